@@ -64,6 +64,25 @@ struct bbapi_struct {
 	{};
 #endif /* #ifdef __cplusplus */
 };
+
+#if BIOSAPIERR_OFFSET > 0
+#define BBAPI_MODE_BULK 0x1	// throughput request, scheduled shortest job first
+
+/**
+ * struct bbapi_mode - optional request options referenced by pMode
+ * @nTimeoutUs: fail with ETIME if the BIOS call can't start within this
+ *              many microseconds, because the BIOS is busy with another call.
+ *              Zero means no deadline.
+ * @nFlags: BBAPI_MODE_* flags, all other bits are reserved and must be zero
+ *
+ * Drivers without pMode support reject any pMode != NULL with EINVAL,
+ * drivers without bulk scheduling reject BBAPI_MODE_BULK as reserved flag.
+ */
+struct bbapi_mode {
+	uint32_t nTimeoutUs;
+	uint32_t nFlags;
+};
+#endif
 #endif /* #ifndef WINDOWS */
 
 #define BADEVICE_MBINFO_snprintf(p, buffer, len) \
@@ -9,10 +9,15 @@
 #include <linux/module.h>
 #include <linux/moduleparam.h>
 #include <linux/kernel.h>
+#include <linux/debugfs.h>
+#include <linux/delay.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
 #include <linux/types.h>
 #include <linux/fs.h>
 #include <linux/kdev_t.h>
 #include <linux/platform_device.h>
+#include <linux/seq_file.h>
 #include <linux/slab.h>
 #include <linux/version.h>
 #include <linux/vmalloc.h>
@@ -29,7 +34,14 @@
 #include <linux/uaccess.h>
 #endif
 
+#if (LINUX_VERSION_CODE < KERNEL_VERSION(4,11,0))
+#include <linux/sched.h>
+#else
+#include <linux/sched/signal.h>
+#endif
+
 #include "api.h"
+#include "history.h"
 #include "TcBaDevDef.h"
 
 #define DRV_VERSION "0.2.5"
@@ -42,6 +54,8 @@
 /* Global Variables */
 static struct bbapi_object g_bbapi;
 
+#define BBAPI_LOCK_POLL_US 50	// Polling interval while waiting for a busy BIOS with deadline
+
 static unsigned long g_bbapi_search_area = BBIOSAPI_SIGNATURE_SEARCH_AREA;
 module_param_named(search_area, g_bbapi_search_area, ulong, 0);
 MODULE_PARM_DESC(search_area, "Size in bytes of the area to search for the BBAPI signature.");
@@ -116,12 +130,18 @@ unsigned int bbapi_rw(uint32_t group, uint32_t offset,
 		.nOutBufferSize = size_out
 	};
 	volatile unsigned int result = 0;
+	u64 start;
 
 	if (!g_bbapi.entry)
 		return BIOSAPI_SRVNOTSUPP;
 
 	mutex_lock(&g_bbapi.mutex);
+	start = ktime_get_ns();
 	result = bbapi_call(in, out, g_bbapi.entry, &cmd, bytes_written);
+	if (!result) {
+		bbapi_cost_update(&g_bbapi.sched, group, offset,
+				  ktime_get_ns() - start);
+	}
 	mutex_unlock(&g_bbapi.mutex);
 	if (result) {
 		pr_debug("%s(0x%x:0x%x) failed with: 0x%x\n", __func__,
@@ -164,6 +184,7 @@ EXPORT_SYMBOL(bbapi_board_is);
  * bbapi_copy_bios() - Copy BIOS from SPI flash into RAM
  * @bbapi: pointer to a not initialized bbapi_object
  * @pos: pointer to the BIOS identifier string in flash
+ * @phys: physical address of @pos
  *
  * We use BIOS shadowing to increase realtime performance.
  * The BIOS identifier string is followed by the 32-Bit BIOS API
@@ -179,7 +200,7 @@ EXPORT_SYMBOL(bbapi_board_is);
  * Return: 0 for success, -ENOMEM if the allocation of kernel memory fails
  */
 static int __init bbapi_copy_bios(struct bbapi_object *bbapi,
-				  uint8_t __iomem * pos)
+				  uint8_t __iomem * pos, phys_addr_t phys)
 {
 	const uint32_t offset = ioread32(pos + 8);
 	const size_t size = offset + 4096;
@@ -197,6 +218,8 @@ static int __init bbapi_copy_bios(struct bbapi_object *bbapi,
 	
 	memcpy_fromio(bbapi->memory, pos, size);
 	bbapi->entry = bbapi->memory + offset;
+	bbapi->size = size;
+	bbapi->phys = phys;
 	return 0;
 }
 
@@ -235,7 +258,9 @@ static int __init bbapi_find_bios(struct bbapi_object *bbapi)
 			const uint32_t high = ioread32(pos + 4);
 			const uint64_t lword = ((uint64_t) high << 32 | low);
 			if (BBIOSAPI_SIGNATURE == lword) {
-				result = bbapi_copy_bios(bbapi, pos);
+				result = bbapi_copy_bios(bbapi, pos,
+							 BBIOSAPI_SIGNATURE_PHYS_START_ADDR
+							 + (pos - start));
 				pr_info
 				    ("BIOS found and copied from: %p + 0x%zx | %zu\n",
 				     start, pos - start, off);
@@ -248,6 +273,109 @@ cleanup:
 	return result;
 }
 
+/**
+ * bbapi_layout_show() - describe the BIOS copy in RAM
+ *
+ * Samples of "perf top" inside the BIOS show up as raw vmalloc addresses.
+ * Subtract "memory" to get the offset into the BIOS image, which is the
+ * same as the offset in flash relative to "phys".
+ */
+static int bbapi_layout_show(struct seq_file *m, void *v)
+{
+	const struct bbapi_object *const bbapi = m->private;
+	const unsigned long memory = (unsigned long)bbapi->memory;
+	const unsigned long entry = (unsigned long)bbapi->entry;
+
+	seq_printf(m, "signature: %.8s\n", (const char *)bbapi->memory);
+	seq_printf(m, "phys:      0x%llx\n", (unsigned long long)bbapi->phys);
+	seq_printf(m, "memory:    0x%lx-0x%lx\n", memory, memory + bbapi->size);
+	seq_printf(m, "size:      0x%zx (%lu pages)\n", bbapi->size,
+		   (unsigned long)(PAGE_ALIGN(bbapi->size) >> PAGE_SHIFT));
+	seq_printf(m, "entry:     0x%lx (+0x%lx)\n", entry, entry - memory);
+	return 0;
+}
+
+/**
+ * bbapi_kallsyms_show() - symbols of the BIOS copy in /proc/kallsyms format
+ *
+ * The BIOS image has no symbol table and its header holds nothing but the
+ * identifier and the offset of the entry function. So all we know are the
+ * image bounds and the entry point, the routines behind the entry function
+ * can't be named. perf derives the size of a symbol from the next one, so
+ * "bbapi_bios_image" covers everything in front of the entry function and
+ * "bbapi_bios_end" terminates the entry function. Append this to a copy of
+ * /proc/kallsyms and pass it to "perf report --kallsyms". Use the offsets
+ * from "layout" to map samples inside the entry function back to the BIOS.
+ */
+static int bbapi_kallsyms_show(struct seq_file *m, void *v)
+{
+	const struct bbapi_object *const bbapi = m->private;
+	const unsigned long memory = (unsigned long)bbapi->memory;
+
+	seq_printf(m, "%016lx t bbapi_bios_image\n", memory);
+	seq_printf(m, "%016lx t bbapi_bios_entry\n",
+		   (unsigned long)bbapi->entry);
+	seq_printf(m, "%016lx t bbapi_bios_end\n", memory + bbapi->size);
+	return 0;
+}
+
+static int bbapi_layout_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, bbapi_layout_show, inode->i_private);
+}
+
+static int bbapi_kallsyms_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, bbapi_kallsyms_show, inode->i_private);
+}
+
+static const struct file_operations bbapi_layout_fops = {
+	.owner = THIS_MODULE,
+	.open = bbapi_layout_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static const struct file_operations bbapi_kallsyms_fops = {
+	.owner = THIS_MODULE,
+	.open = bbapi_kallsyms_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int bbapi_sched_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, bbapi_sched_show, inode->i_private);
+}
+
+static const struct file_operations bbapi_sched_fops = {
+	.owner = THIS_MODULE,
+	.open = bbapi_sched_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+/**
+ * bbapi_init_debugfs() - create <debugfs>/bbapi/{layout,kallsyms,sched}
+ *
+ * layout and kallsyms expose kernel addresses, so they are readable by
+ * root only.
+ * Like everywhere else in the kernel, debugfs errors are not fatal.
+ */
+static void __init bbapi_init_debugfs(struct bbapi_object *bbapi)
+{
+	bbapi->debugfs = debugfs_create_dir(KBUILD_MODNAME, NULL);
+	debugfs_create_file("layout", 0400, bbapi->debugfs, bbapi,
+			    &bbapi_layout_fops);
+	debugfs_create_file("kallsyms", 0400, bbapi->debugfs, bbapi,
+			    &bbapi_kallsyms_fops);
+	debugfs_create_file("sched", 0444, bbapi->debugfs, &bbapi->sched,
+			    &bbapi_sched_fops);
+}
+
 /**
  * You have to hold the lock on bbapi->mutex when calling this function!!!
  */
@@ -256,6 +384,7 @@ static int bbapi_ioctl_mutexed(struct bbapi_object *const bbapi,
 {
 	unsigned int written = 0;
 	unsigned int ret;
+	u64 start;
 
 	if (cmd->nInBufferSize > sizeof(bbapi->in)) {
 		pr_err("%s(): nInBufferSize invalid\n", __FUNCTION__);
@@ -272,12 +401,15 @@ static int bbapi_ioctl_mutexed(struct bbapi_object *const bbapi,
 		return -EFAULT;
 	}
 	// Call the BIOS API
+	start = ktime_get_ns();
 	ret = bbapi_call(bbapi->in, bbapi->out, bbapi->entry, cmd, &written);
 	if (ret) {
 		pr_debug("%s(0x%x:0x%x) failed with: 0x%x\n", __func__,
 		         cmd->nIndexGroup, cmd->nIndexOffset, ret);
 		return -(ret | BIOSAPIERR_OFFSET);
 	}
+	bbapi_cost_update(&bbapi->sched, cmd->nIndexGroup, cmd->nIndexOffset,
+			  ktime_get_ns() - start);
 	// Copy the BIOS output to the output buffer in user space
 	if (copy_to_user(cmd->pOutBuffer, bbapi->out, written)) {
 		pr_err("%s(): copy_to_user() failed\n", __FUNCTION__);
@@ -290,9 +422,71 @@ static int bbapi_ioctl_mutexed(struct bbapi_object *const bbapi,
 	return 0;
 }
 
+/**
+ * bbapi_lock() - acquire bbapi->mutex for a request from user space
+ * @bbapi: the bbapi_object to lock
+ * @nonblock: O_NONBLOCK was set, don't wait for a busy BIOS
+ * @deadline_ns: ktime_get_ns() based deadline or 0 to wait forever
+ *
+ * The kernel mutex has no timed lock operation, so with a deadline we
+ * poll mutex_trylock() every BBAPI_LOCK_POLL_US. A BIOS call takes about
+ * the same time, so this doesn't add much latency compared to the call
+ * we are waiting for. O_NONBLOCK takes precedence over a deadline. The
+ * deadline is checked before the first attempt, as a bulk request may
+ * have used it up already, and again after a polled attempt succeeded.
+ *
+ * Return: 0 if the lock was acquired, -EAGAIN if the BIOS is busy and
+ * O_NONBLOCK is set, -ETIME if the deadline expired, -EINTR if a signal
+ * is pending while waiting for the deadline
+ */
+static int bbapi_lock(struct bbapi_object *const bbapi, bool nonblock,
+		      u64 deadline_ns)
+{
+	s64 remaining;
+
+	if (deadline_ns && ktime_get_ns() >= deadline_ns) {
+		return -ETIME;
+	}
+
+	if (mutex_trylock(&bbapi->mutex)) {
+		return 0;
+	}
+
+	if (nonblock) {
+		return -EAGAIN;
+	}
+
+	if (!deadline_ns) {
+		mutex_lock(&bbapi->mutex);
+		return 0;
+	}
+
+	do {
+		remaining = div_s64((s64) (deadline_ns - ktime_get_ns()),
+				    NSEC_PER_USEC);
+		if (remaining <= 0) {
+			return -ETIME;
+		}
+		if (signal_pending(current)) {
+			return -EINTR;
+		}
+		usleep_range(min_t(s64, remaining, BBAPI_LOCK_POLL_US / 2),
+			     min_t(s64, remaining, BBAPI_LOCK_POLL_US));
+	} while (!mutex_trylock(&bbapi->mutex));
+
+	if (ktime_get_ns() >= deadline_ns) {
+		mutex_unlock(&bbapi->mutex);
+		return -ETIME;
+	}
+	return 0;
+}
+
 static long bbapi_ioctl(struct file *f, unsigned int cmd, unsigned long arg)
 {
 	struct bbapi_struct bbstruct;
+	struct bbapi_mode mode = { 0 };
+	const bool nonblock = f->f_flags & O_NONBLOCK;
+	u64 deadline_ns = 0;
 	size_t size = sizeof(bbstruct);
 	int result = -EINVAL;
 	if (!g_bbapi.entry) {
@@ -317,10 +511,21 @@ static long bbapi_ioctl(struct file *f, unsigned int cmd, unsigned long arg)
 		pr_err("copy_from_user failed\n");
 		return -EINVAL;
 	}
-	// pMode is reserved for future use
+	// pMode is optional, but if used the reserved flags have to be zero
 	if (bbstruct.pMode) {
-		pr_info("Setting pMode to nullptr is mandatory!\n");
-		return -EINVAL;
+		if (copy_from_user(&mode, bbstruct.pMode, sizeof(mode))) {
+			pr_err("copy_from_user failed\n");
+			return -EFAULT;
+		}
+		if (mode.nFlags & ~BBAPI_MODE_BULK) {
+			pr_info("pMode->nFlags: 0x%x reserved bits must be zero!\n",
+				mode.nFlags);
+			return -EINVAL;
+		}
+		if (mode.nTimeoutUs) {
+			deadline_ns = ktime_get_ns() +
+			    (u64) mode.nTimeoutUs * NSEC_PER_USEC;
+		}
 	}
 
 	if (bbstruct.nIndexOffset >= 0xB0) {
@@ -329,9 +534,25 @@ static long bbapi_ioctl(struct file *f, unsigned int cmd, unsigned long arg)
 		return -EACCES;
 	}
 
-	mutex_lock(&g_bbapi.mutex);
-	result = bbapi_ioctl_mutexed(&g_bbapi, &bbstruct);
-	mutex_unlock(&g_bbapi.mutex);
+	// Bulk requests are scheduled shortest job first, see bulk_sched.c
+	if (mode.nFlags & BBAPI_MODE_BULK) {
+		result = bbapi_bulk_acquire(&g_bbapi.sched, bbstruct.nIndexGroup,
+					    bbstruct.nIndexOffset, nonblock,
+					    deadline_ns);
+		if (result) {
+			return result;
+		}
+	}
+
+	result = bbapi_lock(&g_bbapi, nonblock, deadline_ns);
+	if (!result) {
+		result = bbapi_ioctl_mutexed(&g_bbapi, &bbstruct);
+		mutex_unlock(&g_bbapi.mutex);
+	}
+
+	if (mode.nFlags & BBAPI_MODE_BULK) {
+		bbapi_bulk_release(&g_bbapi.sched);
+	}
 	return result;
 }
 
@@ -394,14 +615,17 @@ inline static bool bbapi_supports(uint32_t group, uint32_t offset)
 }
 
 #define bbapi_supports_display() \
-	bbapi_supports(BIOSIGRP_CXPWRSUPP, BIOSIOFFS_CXPWRSUPP_ENABLEBACKLIGHT)
+	bbapi_board_has(CXPWRSUPP, \
+		bbapi_supports(BIOSIGRP_CXPWRSUPP, BIOSIOFFS_CXPWRSUPP_ENABLEBACKLIGHT))
 
 #define bbapi_supports_power() \
-	bbapi_supports(BIOSIGRP_CXPWRSUPP, BIOSIOFFS_CXPWRSUPP_GETTYPE)
+	(BBAPI_FEATURE(POWER) && bbapi_board_has(CXUPS, \
+		bbapi_supports(BIOSIGRP_CXPWRSUPP, BIOSIOFFS_CXPWRSUPP_GETTYPE)))
 
 #define bbapi_supports_sups() \
-	(bbapi_supports(BIOSIGRP_SUPS, BIOSIOFFS_SUPS_GPIO_PIN_EX) \
-	 || bbapi_supports(BIOSIGRP_SUPS, BIOSIOFFS_SUPS_GPIO_PIN))
+	(BBAPI_FEATURE(SUPS) && bbapi_board_has(SUPS, \
+		(bbapi_supports(BIOSIGRP_SUPS, BIOSIOFFS_SUPS_GPIO_PIN_EX) \
+		 || bbapi_supports(BIOSIGRP_SUPS, BIOSIOFFS_SUPS_GPIO_PIN))))
 
 #ifdef __i386__
 typedef void __iomem *(*map_func) (int64_t, uint32_t, ...);
@@ -474,6 +698,7 @@ static int __init bbapi_init_module(void)
 
 	pr_info("%s, %s\n", DRV_DESCRIPTION, DRV_VERSION);
 	mutex_init(&g_bbapi.mutex);
+	bbapi_sched_init(&g_bbapi.sched);
 
 	result = bbapi_find_bios(&g_bbapi);
 	if (result) {
@@ -507,7 +732,10 @@ static int __init bbapi_init_module(void)
 	if (bbapi_supports_display()) {
 		update_display();
 	}
-	return bbapi_init_bios();
+	bbapi_init_debugfs(&g_bbapi);
+	result = bbapi_init_bios();
+	bbapi_history_init(g_bbapi.debugfs);
+	return result;
 
 rollback_sups:
 	if (bbapi_supports_sups()) {
@@ -529,6 +757,8 @@ static void __exit bbapi_exit(void)
 	if (!g_bbapi.memory)
 		return;
 
+	bbapi_history_exit();
+	debugfs_remove_recursive(g_bbapi.debugfs);
 	bbapi_exit_bios();
 	simple_cdev_remove(&g_bbapi.dev);
 
@@ -12,16 +12,46 @@
 #define pr_fmt(fmt) KBUILD_MODNAME ": " fmt
 
 #include <linux/mutex.h>
+#include "bulk_sched.h"
 #include "simple_cdev.h"
 
 #define BBIOSAPI_SIGNATURE_PHYS_START_ADDR 0xFFE00000	// Defining the Physical start address for the search
 #define BBIOSAPI_SIGNATURE_SEARCH_AREA     0x001FFFFF	// Defining the Memory search area size
 #define BBAPI_BUFFER_SIZE 256	// maximum size of a buffer shared between user and kernel space
 
+/**
+ * In-tree the drivers and the board profile are selected with Kconfig.
+ * Out of tree builds (CONFIG_BBAPI unknown to the kernel) contain all
+ * features and probe the capabilities of the board at load time.
+ */
+#if IS_ENABLED(CONFIG_BBAPI)
+#define BBAPI_FEATURE(f) IS_ENABLED(CONFIG_BBAPI_##f)
+#else
+#define BBAPI_FEATURE(f) 1
+#endif
+
+/**
+ * bbapi_board_has() - capability of the board
+ * @cap: CXPWRSUPP, CXUPS or SUPS
+ * @probe: expression to detect the capability at runtime
+ *
+ * With a board profile this is a compile-time constant and @probe is
+ * never evaluated.
+ */
+#if IS_ENABLED(CONFIG_BBAPI) && !IS_ENABLED(CONFIG_BBAPI_BOARD_PROBE)
+#define bbapi_board_has(cap, probe) IS_ENABLED(CONFIG_BBAPI_HAS_##cap)
+#else
+#define bbapi_board_has(cap, probe) (probe)
+#endif
+
 /**
  * struct bbapi_object - manage access to Beckhoff BIOS functions
  * @memory: pointer to a BIOS copy in RAM
  * @entry: function pointer to the BIOS API function in RAM
+ * @size: size of the BIOS copy in RAM
+ * @phys: physical address of the BIOS in flash
+ * @debugfs: directory with the layout of the BIOS copy for profiling
+ * @sched: execution time of BIOS commands and queue of bulk requests
  * @in: buffer to exchange data between user space and BIOS
  * @out: buffer to exchange data between BIOS and user space
  * @dev: meta data for the character device interface
@@ -32,10 +62,14 @@
 struct bbapi_object {
 	uint8_t *memory;
 	void *entry;
+	size_t size;
+	phys_addr_t phys;
+	struct dentry *debugfs;
 	char in[BBAPI_BUFFER_SIZE];
 	char out[BBAPI_BUFFER_SIZE];
 	struct simple_cdev dev;
 	struct mutex mutex;
+	struct bbapi_sched sched;
 };
 
 extern unsigned int bbapi_read(uint32_t group, uint32_t offset,
@@ -49,4 +83,12 @@ extern unsigned int bbapi_rw(uint32_t group, uint32_t offset,
 				void __kernel * out, uint32_t size_out, uint32_t *bytes_written);
 
 extern int bbapi_board_is(const char *boardname);
+
+#if BBAPI_FEATURE(HISTORY)
+extern void bbapi_history_freeze(const char *reason);
+#else
+static inline void bbapi_history_freeze(const char *reason)
+{
+}
+#endif
 #endif /* #ifndef __API_H_ */
@@ -0,0 +1,557 @@
+// SPDX-License-Identifier: MIT
+/**
+    Benchmark suite for the BBAPI driver stack
+
+    usage: bbapi-bench [options] [-o <result.json>]
+           bbapi-bench -c <baseline.json> <result.json> [-T <percent>]
+
+    Measures:
+      - ioctl latency percentiles of every readable value in BBAPI_VALUES
+      - sensor enumeration time (COUNT_SENSORS + all SENSORINFOs)
+      - ioctl throughput with 1..N threads
+      - write throughput of the CX2100 display (-D)
+      - watchdog ping latency (-W, arms the watchdog!)
+
+    All device paths can be changed, so the suite can run against an
+    emulated device as well. The comparison mode flattens both JSON files
+    and reports every metric which got worse by more than <percent>:
+    metrics ending with "_ns" are latencies (lower is better), metrics
+    ending with "_per_sec" are throughputs (higher is better). Latencies
+    only include successful calls, failed ones are counted as "errors",
+    any increase of them is a regression.
+
+    Copyright (C) 2026 Beckhoff Automation GmbH & Co. KG
+*/
+
+#include "bbapi_client.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ctype.h>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#ifndef __FreeBSD__
+#include <linux/watchdog.h>
+#endif /* #ifndef __FreeBSD__ */
+
+struct bench_config {
+	const char *bbapi;
+	const char *display;
+	const char *watchdog;
+	unsigned iterations;
+	unsigned max_threads;
+	double seconds;
+};
+
+/**
+ * struct latency - durations of successful calls
+ * @samples: latency of each successful call
+ * @errors: number of failed calls, not part of @samples
+ */
+struct latency {
+	std::vector < uint64_t > samples;
+	size_t errors;
+
+	latency() : errors(0) {
+	}
+
+	void add(uint64_t start, bool ok) {
+		if (ok) {
+			samples.push_back(bbapi_clock_ns() - start);
+		} else {
+			++errors;
+		}
+	}
+
+	void print(FILE * out, const char *indent) {
+		if (samples.empty()) {
+			if (errors) {
+				fprintf(out, "{\"count\": 0, \"errors\": %zu}",
+					errors);
+			} else {
+				fprintf(out, "null");
+			}
+			return;
+		}
+		std::sort(samples.begin(), samples.end());
+		double sum = 0;
+		for (size_t i = 0; i < samples.size(); ++i) {
+			sum += samples[i];
+		}
+		fprintf(out, "{\n"
+			"%s  \"count\": %zu,\n"
+			"%s  \"errors\": %zu,\n"
+			"%s  \"mean_ns\": %.0f,\n"
+			"%s  \"min_ns\": %llu,\n"
+			"%s  \"p50_ns\": %llu,\n"
+			"%s  \"p90_ns\": %llu,\n"
+			"%s  \"p99_ns\": %llu,\n"
+			"%s  \"p999_ns\": %llu,\n"
+			"%s  \"max_ns\": %llu\n%s}",
+			indent, samples.size(),
+			indent, errors,
+			indent, sum / samples.size(),
+			indent, (unsigned long long)samples.front(),
+			indent, percentile(0.5),
+			indent, percentile(0.9),
+			indent, percentile(0.99),
+			indent, percentile(0.999),
+			indent, (unsigned long long)samples.back(), indent);
+	}
+
+	unsigned long long percentile(double p) const {
+		const size_t i = p * (samples.size() - 1) + 0.5;
+		return samples[i];
+	}
+};
+
+static bool bench_ioctl(int fd, const struct bbapi_value *v, unsigned n,
+			struct latency *lat)
+{
+	int64_t value;
+
+	/* skip values not supported by this board */
+	if (bbapi_read_value(fd, v, &value)) {
+		return false;
+	}
+
+	lat->samples.reserve(n);
+	while (n--) {
+		const uint64_t start = bbapi_clock_ns();
+		lat->add(start, !bbapi_read_value(fd, v, &value));
+	}
+	return true;
+}
+
+static bool bench_sensors(int fd, unsigned n, struct latency *lat,
+			  uint32_t * num_sensors)
+{
+	if (bbapi_ioctl_read(fd, BIOSIGRP_SYSTEM,
+			     BIOSIOFFS_SYSTEM_COUNT_SENSORS, num_sensors,
+			     sizeof(*num_sensors))) {
+		return false;
+	}
+
+	while (n--) {
+		const uint64_t start = bbapi_clock_ns();
+		uint32_t count = 0;
+		bool ok = !bbapi_ioctl_read(fd, BIOSIGRP_SYSTEM,
+					    BIOSIOFFS_SYSTEM_COUNT_SENSORS,
+					    &count, sizeof(count));
+		for (uint32_t i = BIOSIOFFS_SYSTEM_SENSOR_MIN; i <= count; ++i) {
+			SENSORINFO info;
+			ok = !bbapi_ioctl_read(fd, BIOSIGRP_SYSTEM, i, &info,
+					       sizeof(info)) && ok;
+		}
+		lat->add(start, ok);
+	}
+	return true;
+}
+
+/**
+ * bench_scaling() - ioctl throughput with @threads concurrent readers
+ *
+ * Every thread uses its own file descriptor to exclude any user space
+ * serialization. The BIOS itself is serialized by the driver mutex.
+ *
+ * Return: number of ioctl calls per second
+ */
+static double bench_scaling(const struct bench_config *cfg, unsigned threads)
+{
+	static const struct bbapi_value platform =
+	    BBAPI_VALUE(GENERAL, GETPLATFORMINFO, uint8_t, "");
+	std::vector < std::thread > workers;
+	std::atomic < bool > stop(false);
+	std::atomic < uint64_t > calls(0);
+
+	for (unsigned i = 0; i < threads; ++i) {
+		workers.push_back(std::thread([&]() {
+			const int fd = open(cfg->bbapi, O_RDWR);
+			uint64_t local = 0;
+			int64_t value;
+			while (-1 != fd && !stop) {
+				local += !bbapi_read_value(fd, &platform, &value);
+			}
+			calls += local;
+			if (-1 != fd) {
+				close(fd);
+			}
+		}));
+	}
+
+	const uint64_t start = bbapi_clock_ns();
+	std::this_thread::sleep_for(std::chrono::duration < double >
+				    (cfg->seconds));
+	stop = true;
+	for (auto & t:workers) {
+		t.join();
+	}
+	return calls * 1e9 / (bbapi_clock_ns() - start);
+}
+
+/**
+ * bench_display() - full screen updates written to the text display
+ *
+ * Return: number of write() calls per second or a negative value if the
+ * display is not available
+ */
+static double bench_display(const struct bench_config *cfg)
+{
+	static const char screen[] = "\f0123456789ABCDEF\nFEDCBA9876543210";
+	const int fd = open(cfg->display, O_WRONLY);
+	uint64_t writes = 0;
+
+	if (-1 == fd) {
+		return -1;
+	}
+
+	const uint64_t start = bbapi_clock_ns();
+	const uint64_t end = start + cfg->seconds * 1e9;
+	uint64_t now = start;
+	while (now < end) {
+		if (sizeof(screen) - 1 != write(fd, screen, sizeof(screen) - 1)) {
+			close(fd);
+			return -1;
+		}
+		++writes;
+		now = bbapi_clock_ns();
+	}
+	close(fd);
+	return writes * 1e9 / (now - start);
+}
+
+static bool bench_watchdog(const struct bench_config *cfg, unsigned n,
+			   struct latency *lat)
+{
+#ifdef WDIOC_KEEPALIVE
+	const int fd = open(cfg->watchdog, O_WRONLY);
+	int timeout = 60;
+
+	if (-1 == fd) {
+		return false;
+	}
+
+	if (ioctl(fd, WDIOC_SETTIMEOUT, &timeout)) {
+		perror("WDIOC_SETTIMEOUT");
+	}
+	while (n--) {
+		const uint64_t start = bbapi_clock_ns();
+		lat->add(start, !ioctl(fd, WDIOC_KEEPALIVE, 0));
+	}
+
+	/* magic close to disarm the watchdog */
+	if (1 != write(fd, "V", 1)) {
+		perror("watchdog magic close");
+	}
+	close(fd);
+	return true;
+#else
+	return false;
+#endif
+}
+
+static int run(const struct bench_config *cfg, bool display, bool watchdog,
+	       FILE * out)
+{
+	const int fd = open(cfg->bbapi, O_RDWR);
+	uint32_t num_sensors = 0;
+	struct latency sensors;
+	const char *sep = "";
+
+	if (-1 == fd) {
+		fprintf(stderr, "Open '%s' failed\n", cfg->bbapi);
+		return -1;
+	}
+
+	fprintf(out, "{\n  \"iterations\": %u,\n  \"ioctl\": {", cfg->iterations);
+	for (size_t i = 0; i < BBAPI_NUM_VALUES; ++i) {
+		struct latency lat;
+		if (bench_ioctl(fd, &BBAPI_VALUES[i], cfg->iterations, &lat)) {
+			fprintf(out, "%s\n    \"%s\": ", sep, BBAPI_VALUES[i].name);
+			lat.print(out, "    ");
+			sep = ",";
+		}
+	}
+	fprintf(out, "\n  },\n  \"sensor_enumeration\": ");
+	if (bench_sensors(fd, cfg->iterations / 10 + 1, &sensors, &num_sensors)) {
+		sensors.print(out, "  ");
+	} else {
+		fprintf(out, "null");
+	}
+	fprintf(out, ",\n  \"num_sensors\": %u,\n  \"scaling\": {", num_sensors);
+	close(fd);
+
+	sep = "";
+	for (unsigned t = 1;; t = std::min(2 * t, cfg->max_threads)) {
+		fprintf(out, "%s\n    \"threads_%u\": {\"calls_per_sec\": %.0f}",
+			sep, t, bench_scaling(cfg, t));
+		sep = ",";
+		if (t == cfg->max_threads) {
+			break;
+		}
+	}
+	fprintf(out, "\n  }");
+
+	if (display) {
+		const double rate = bench_display(cfg);
+		if (rate < 0) {
+			fprintf(out, ",\n  \"display\": null");
+		} else {
+			fprintf(out, ",\n  \"display\": {\"writes_per_sec\": %.1f}",
+				rate);
+		}
+	}
+
+	if (watchdog) {
+		struct latency lat;
+		fprintf(out, ",\n  \"watchdog_ping\": ");
+		if (bench_watchdog(cfg, cfg->iterations, &lat)) {
+			lat.print(out, "  ");
+		} else {
+			fprintf(out, "null");
+		}
+	}
+	fprintf(out, "\n}\n");
+	return 0;
+}
+
+/**
+ * json_flatten() - minimal JSON reader for bbapi-bench results
+ *
+ * Stores every number as metrics["path/to/key"]. Strings, booleans and
+ * null are skipped.
+ */
+static bool json_flatten(const char **p, const std::string & path,
+			 std::map < std::string, double >&metrics)
+{
+	while (isspace(**p)) {
+		++*p;
+	}
+
+	if ('{' == **p || '[' == **p) {
+		const char close = ('{' == **p) ? '}' : ']';
+		size_t index = 0;
+		++*p;
+		for (;;) {
+			std::string key = std::to_string(index++);
+			while (isspace(**p) || ',' == **p) {
+				++*p;
+			}
+			if (close == **p) {
+				++*p;
+				return true;
+			}
+			if ('}' == close) {
+				const char *const end = strchr(*p + 1, '"');
+				if ('"' != **p || !end) {
+					return false;
+				}
+				key.assign(*p + 1, end);
+				*p = end + 1;
+				while (isspace(**p)) {
+					++*p;
+				}
+				if (':' != *(*p)++) {
+					return false;
+				}
+			}
+			if (!json_flatten(p, path.empty() ? key : path + "/" + key,
+					  metrics)) {
+				return false;
+			}
+		}
+	}
+
+	if ('"' == **p) {
+		const char *const end = strchr(*p + 1, '"');
+		if (!end) {
+			return false;
+		}
+		*p = end + 1;
+		return true;
+	}
+
+	char *end;
+	const double value = strtod(*p, &end);
+	if (end != *p) {
+		metrics[path] = value;
+	} else {
+		while (isalpha(*end)) {
+			++end;
+		}
+	}
+	const bool ok = end != *p;
+	*p = end;
+	return ok;
+}
+
+static bool load_metrics(const char *path,
+			 std::map < std::string, double >&metrics)
+{
+	FILE *const f = fopen(path, "r");
+	std::string text;
+	char buf[4096];
+	size_t n;
+
+	if (!f) {
+		perror(path);
+		return false;
+	}
+	while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+		text.append(buf, n);
+	}
+	fclose(f);
+
+	const char *p = text.c_str();
+	if (!json_flatten(&p, "", metrics)) {
+		fprintf(stderr, "'%s' is no valid bbapi-bench result\n", path);
+		return false;
+	}
+	return true;
+}
+
+static bool ends_with(const std::string & s, const char *suffix)
+{
+	const size_t len = strlen(suffix);
+	return s.size() >= len && !s.compare(s.size() - len, len, suffix);
+}
+
+static int compare(const char *baseline, const char *result, double threshold)
+{
+	std::map < std::string, double >old_metrics;
+	std::map < std::string, double >new_metrics;
+	int regressions = 0;
+
+	if (!load_metrics(baseline, old_metrics)
+	    || !load_metrics(result, new_metrics)) {
+		return -1;
+	}
+
+	for (auto & it:new_metrics) {
+		const bool latency = ends_with(it.first, "_ns");
+		const bool throughput = ends_with(it.first, "_per_sec");
+		auto old = old_metrics.find(it.first);
+		if (ends_with(it.first, "/errors")) {
+			const double before =
+			    old == old_metrics.end() ? 0 : old->second;
+			const bool regression = it.second > before;
+			regressions += regression;
+			printf("%-10s %-60s %14.0f -> %14.0f\n",
+			       regression ? "REGRESSION" : "ok",
+			       it.first.c_str(), before, it.second);
+			continue;
+		}
+		if ((!latency && !throughput) || old == old_metrics.end()
+		    || old->second <= 0) {
+			continue;
+		}
+
+		double change = 100.0 * (it.second - old->second) / old->second;
+		if (throughput) {
+			change = -change;
+		}
+		const bool regression = change > threshold;
+		regressions += regression;
+		printf("%-10s %-60s %14.1f -> %14.1f (%+.1f%%)\n",
+		       regression ? "REGRESSION" : "ok", it.first.c_str(),
+		       old->second, it.second, change);
+	}
+	printf("%d regression(s) above %.1f%%\n", regressions, threshold);
+	return regressions ? 1 : 0;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+		"usage: %s [-b <bbapi>] [-n <iterations>] [-t <threads>] [-s <sec>]\n"
+		"       [-D [<display>]] [-W [<watchdog>]] [-o <result.json>]\n"
+		"       %s -c <baseline.json> <result.json> [-T <percent>]\n\n"
+		" -b  BBAPI device (default: " BBAPI_DEVICE ")\n"
+		" -n  iterations per latency measurement (default: 1000)\n"
+		" -t  maximum number of threads for the scaling test (default: 8)\n"
+		" -s  duration of each throughput test in seconds (default: 2)\n"
+		" -D  benchmark display writes (default: /dev/cx_display)\n"
+		" -W  benchmark watchdog pings (default: /dev/watchdog)\n"
+		"     WARNING: the watchdog is armed with a 60s timeout and\n"
+		"     disarmed by a magic close at the end of the test.\n"
+		" -o  write results to file instead of stdout\n"
+		" -c  compare two result files, returns 1 on regressions\n"
+		" -T  regression threshold in percent (default: 10)\n", name, name);
+}
+
+int main(int argc, char *argv[])
+{
+	struct bench_config cfg = {
+		BBAPI_DEVICE, "/dev/cx_display", "/dev/watchdog", 1000, 8, 2
+	};
+	const char *baseline = NULL;
+	const char *output = NULL;
+	double threshold = 10;
+	bool display = false;
+	bool watchdog = false;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "b:n:t:s:D::W::o:c:T:h")) != -1) {
+		switch (opt) {
+		case 'b':
+			cfg.bbapi = optarg;
+			break;
+		case 'n':
+			cfg.iterations = strtoul(optarg, NULL, 0);
+			break;
+		case 't':
+			cfg.max_threads = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			cfg.seconds = atof(optarg);
+			break;
+		case 'D':
+			display = true;
+			cfg.display = optarg ? optarg : cfg.display;
+			break;
+		case 'W':
+			watchdog = true;
+			cfg.watchdog = optarg ? optarg : cfg.watchdog;
+			break;
+		case 'o':
+			output = optarg;
+			break;
+		case 'c':
+			baseline = optarg;
+			break;
+		case 'T':
+			threshold = atof(optarg);
+			break;
+		default:
+			usage(argv[0]);
+			return -1;
+		}
+	}
+
+	if (baseline) {
+		if (argc - optind != 1) {
+			usage(argv[0]);
+			return -1;
+		}
+		return compare(baseline, argv[optind], threshold);
+	}
+
+	if (argc != optind || !cfg.iterations || !cfg.max_threads
+	    || cfg.seconds <= 0) {
+		usage(argv[0]);
+		return -1;
+	}
+
+	FILE *const out = output ? fopen(output, "w") : stdout;
+	if (!out) {
+		perror(output);
+		return -1;
+	}
+	const int result = run(&cfg, display, watchdog, out);
+	if (output) {
+		fclose(out);
+	}
+	return result;
+}
@@ -0,0 +1,408 @@
+// SPDX-License-Identifier: MIT
+/**
+    Helpers shared by the user space tools accessing /dev/bbapi
+
+    Copyright (C) 2026 Beckhoff Automation GmbH & Co. KG
+*/
+
+#ifndef _BBAPI_CLIENT_H_
+#define _BBAPI_CLIENT_H_
+
+#include "TcBaDevDef.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <string>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifndef __FreeBSD__
+#include <linux/gpio.h>
+#endif /* #ifndef __FreeBSD__ */
+
+#define BBAPI_DEVICE "/dev/bbapi"
+#define BBAPI_BUTTON_NAME "Beckhoff CX2100 Buttons"
+#define BBAPI_PWRFAIL_LINE "sups_pwrfail"
+
+/**
+ * struct bbapi_value - a scalar value readable through /dev/bbapi
+ * @name: identifier, build from the BIOSIOFFS_* define without prefix
+ * @group: IndexGroup
+ * @offset: IndexOffset
+ * @size: number of bytes returned by the BIOS
+ * @is_signed: true if the BIOS returns a two's complement value
+ * @unit: unit of the decoded value
+ *
+ * Values with side effects on read (e.g. "get and reset" counters)
+ * are intentionally not listed.
+ */
+struct bbapi_value {
+	const char *name;
+	uint32_t group;
+	uint32_t offset;
+	uint32_t size;
+	bool is_signed;
+	const char *unit;
+};
+
+#define BBAPI_VALUE(GROUP, OFFSET, TYPE, UNIT) \
+	{#GROUP "_" #OFFSET, BIOSIGRP_##GROUP, BIOSIOFFS_##GROUP##_##OFFSET, \
+	 sizeof(TYPE), ((TYPE)-1) < 0, UNIT}
+
+static const struct bbapi_value BBAPI_VALUES[] = {
+	BBAPI_VALUE(GENERAL, GETPLATFORMINFO, uint8_t, ""),
+	BBAPI_VALUE(PWRCTRL, DEVICE_ID, uint8_t, ""),
+	BBAPI_VALUE(PWRCTRL, OPERATING_TIME, uint32_t, "min"),
+	BBAPI_VALUE(PWRCTRL, BOOT_COUNTER, uint16_t, ""),
+	BBAPI_VALUE(SUPS, STATUS, uint8_t, ""),
+	BBAPI_VALUE(SUPS, PWRFAIL_COUNTER, uint16_t, ""),
+	BBAPI_VALUE(SUPS, INTERNAL_PWRF_STATUS, uint8_t, ""),
+	BBAPI_VALUE(SUPS, TEST_RESULT, uint8_t, ""),
+	BBAPI_VALUE(CXPWRSUPP, GETTYPE, uint32_t, ""),
+	BBAPI_VALUE(CXPWRSUPP, GETBOOTCOUNTER, uint32_t, ""),
+	BBAPI_VALUE(CXPWRSUPP, GETOPERATIONTIME, uint32_t, "min"),
+	BBAPI_VALUE(CXPWRSUPP, GET5VOLT, uint16_t, "mV"),
+	BBAPI_VALUE(CXPWRSUPP, GETMAX5VOLT, uint16_t, "mV"),
+	BBAPI_VALUE(CXPWRSUPP, GET12VOLT, uint16_t, "mV"),
+	BBAPI_VALUE(CXPWRSUPP, GETMAX12VOLT, uint16_t, "mV"),
+	BBAPI_VALUE(CXPWRSUPP, GET24VOLT, uint16_t, "mV"),
+	BBAPI_VALUE(CXPWRSUPP, GETMAX24VOLT, uint16_t, "mV"),
+	BBAPI_VALUE(CXPWRSUPP, GETTEMP, int8_t, "C"),
+	BBAPI_VALUE(CXPWRSUPP, GETMINTEMP, int8_t, "C"),
+	BBAPI_VALUE(CXPWRSUPP, GETMAXTEMP, int8_t, "C"),
+	BBAPI_VALUE(CXPWRSUPP, GETCURRENT, uint16_t, "mA"),
+	BBAPI_VALUE(CXPWRSUPP, GETMAXCURRENT, uint16_t, "mA"),
+	BBAPI_VALUE(CXPWRSUPP, GETPOWER, uint32_t, "mW"),
+	BBAPI_VALUE(CXPWRSUPP, GETMAXPOWER, uint32_t, "mW"),
+	BBAPI_VALUE(CXPWRSUPP, GETBUTTONSTATE, uint8_t, ""),
+	BBAPI_VALUE(CXUPS, GETENABLED, uint8_t, ""),
+	BBAPI_VALUE(CXUPS, GETPOWERSTATUS, uint8_t, ""),
+	BBAPI_VALUE(CXUPS, GETBATTERYSTATUS, uint8_t, ""),
+	BBAPI_VALUE(CXUPS, GETBATTERYCAPACITY, uint8_t, "%"),
+	BBAPI_VALUE(CXUPS, GETBATTERYRUNTIME, uint32_t, "s"),
+	BBAPI_VALUE(CXUPS, GETBOOTCOUNTER, uint32_t, ""),
+	BBAPI_VALUE(CXUPS, GETOPERATIONTIME, uint32_t, "min"),
+	BBAPI_VALUE(CXUPS, GETPOWERFAILCOUNT, uint32_t, ""),
+	BBAPI_VALUE(CXUPS, GETBATTERYCRITICAL, uint8_t, ""),
+	BBAPI_VALUE(CXUPS, GETBATTERYPRESENT, uint8_t, ""),
+	BBAPI_VALUE(CXUPS, GETOUTPUTVOLT, uint16_t, "mV"),
+	BBAPI_VALUE(CXUPS, GETMAXOUTPUTVOLT, uint16_t, "mV"),
+	BBAPI_VALUE(CXUPS, GETINPUTVOLT, uint16_t, "mV"),
+	BBAPI_VALUE(CXUPS, GETMAXINPUTVOLT, uint16_t, "mV"),
+	BBAPI_VALUE(CXUPS, GETTEMP, int8_t, "C"),
+	BBAPI_VALUE(CXUPS, GETMINTEMP, int8_t, "C"),
+	BBAPI_VALUE(CXUPS, GETMAXTEMP, int8_t, "C"),
+	BBAPI_VALUE(CXUPS, GETCHARGINGCURRENT, uint16_t, "mA"),
+	BBAPI_VALUE(CXUPS, GETMAXCHARGINGCURRENT, uint16_t, "mA"),
+	BBAPI_VALUE(CXUPS, GETCHARGINGPOWER, uint32_t, "mW"),
+	BBAPI_VALUE(CXUPS, GETMAXCHARGINGPOWER, uint32_t, "mW"),
+	BBAPI_VALUE(CXUPS, GETDISCHARGINGCURRENT, uint16_t, "mA"),
+	BBAPI_VALUE(CXUPS, GETMAXDISCHARGINGCURRENT, uint16_t, "mA"),
+	BBAPI_VALUE(CXUPS, GETDISCHARGINGPOWER, uint32_t, "mW"),
+	BBAPI_VALUE(CXUPS, GETMAXDISCHARGINGPOWER, uint32_t, "mW"),
+};
+
+#define BBAPI_NUM_VALUES (sizeof(BBAPI_VALUES) / sizeof(BBAPI_VALUES[0]))
+#define BBAPI_SENSOR_PREFIX "SYSTEM_SENSOR"
+
+static inline int bbapi_ioctl_read(int fd, uint32_t group, uint32_t offset,
+				   void *out, uint32_t size)
+{
+	struct bbapi_struct data {group, offset, NULL, 0, out, size};
+	return ioctl(fd, BBAPI_CMD, &data);
+}
+
+/**
+ * bbapi_ioctl_read_timeout() - read a value, but don't wait for a busy BIOS
+ * @timeout_us: maximum time to wait for a BIOS call of another client,
+ *              zero waits forever
+ *
+ * Return: 0 on success, -1 with errno ETIME if the deadline expired
+ */
+static inline int bbapi_ioctl_read_timeout(int fd, uint32_t group,
+					   uint32_t offset, void *out,
+					   uint32_t size, uint32_t timeout_us)
+{
+	struct bbapi_mode mode {timeout_us, 0};
+	struct bbapi_struct data {group, offset, NULL, 0, out, size, NULL,
+				  &mode};
+	return ioctl(fd, BBAPI_CMD, &data);
+}
+
+/**
+ * bbapi_ioctl_read_bulk() - read a value, slow commands may wait longer
+ *
+ * For tools reading many values without latency requirement. The driver
+ * runs concurrent bulk requests shortest expected job first.
+ */
+static inline int bbapi_ioctl_read_bulk(int fd, uint32_t group,
+					uint32_t offset, void *out,
+					uint32_t size)
+{
+	struct bbapi_mode mode {0, BBAPI_MODE_BULK};
+	struct bbapi_struct data {group, offset, NULL, 0, out, size, NULL,
+				  &mode};
+	return ioctl(fd, BBAPI_CMD, &data);
+}
+
+static inline int bbapi_ioctl_write(int fd, uint32_t group, uint32_t offset,
+				    const void *in, uint32_t size)
+{
+	struct bbapi_struct data {group, offset, in, size, NULL, 0};
+	return ioctl(fd, BBAPI_CMD, &data);
+}
+
+/**
+ * bbapi_find_value() - lookup a value by name
+ * @name: name of a BBAPI_VALUES entry or "SYSTEM_SENSOR<n>"
+ * @value: filled with the description of the requested value
+ *
+ * SYSTEM_SENSOR<n> describes the current reading (readVal) of the
+ * SENSORINFO with index n.
+ *
+ * Return: true if @name is known
+ */
+static inline bool bbapi_find_value(const char *name,
+				    struct bbapi_value *value)
+{
+	static const size_t prefix_len = sizeof(BBAPI_SENSOR_PREFIX) - 1;
+
+	for (size_t i = 0; i < BBAPI_NUM_VALUES; ++i) {
+		if (!strcmp(name, BBAPI_VALUES[i].name)) {
+			*value = BBAPI_VALUES[i];
+			return true;
+		}
+	}
+
+	if (!strncmp(name, BBAPI_SENSOR_PREFIX, prefix_len)) {
+		char *end;
+		const unsigned long index = strtoul(name + prefix_len, &end, 0);
+		if (!*end && index >= BIOSIOFFS_SYSTEM_SENSOR_MIN
+		    && index <= 0xff) {
+			value->name = name;
+			value->group = BIOSIGRP_SYSTEM;
+			value->offset = index;
+			value->size = sizeof(SENSORINFO);
+			value->is_signed = true;
+			value->unit = "";
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * bbapi_decode_value() - convert a raw BIOS buffer into an integer
+ * @value: description of the buffer content
+ * @raw: buffer filled by the BIOS (little endian)
+ */
+static inline int64_t bbapi_decode_value(const struct bbapi_value *value,
+					 const void *raw)
+{
+	const uint8_t *const bytes = (const uint8_t *)raw;
+	uint64_t result = 0;
+
+	if (BIOSIGRP_SYSTEM == value->group) {
+		const SENSORINFO *const info = (const SENSORINFO *)raw;
+		return info->readVal.value;
+	}
+
+	for (size_t i = value->size; i > 0; --i) {
+		result = (result << 8) | bytes[i - 1];
+	}
+
+	if (value->is_signed && value->size < sizeof(result)) {
+		const uint64_t sign = 1ULL << (8 * value->size - 1);
+		return (int64_t)((result ^ sign) - sign);
+	}
+	return (int64_t)result;
+}
+
+/**
+ * bbapi_read_value() - read and decode a single value
+ *
+ * Return: 0 on success, -1 with errno set otherwise
+ */
+static inline int bbapi_read_value(int fd, const struct bbapi_value *value,
+				   int64_t * result)
+{
+	uint8_t raw[sizeof(SENSORINFO)];
+
+	if (value->size > sizeof(raw)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (bbapi_ioctl_read(fd, value->group, value->offset, raw, value->size)) {
+		return -1;
+	}
+	*result = bbapi_decode_value(value, raw);
+	return 0;
+}
+
+static inline uint64_t bbapi_clock_ns(clockid_t clock = CLOCK_MONOTONIC)
+{
+	struct timespec ts;
+	clock_gettime(clock, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * bbapi_find_button_device() - lookup the event device of bbapi_button
+ *
+ * Return: path of the device or /dev/input/event0 if none is found
+ */
+static inline std::string bbapi_find_button_device(void)
+{
+	static const char name[] = BBAPI_BUTTON_NAME;
+	DIR *const dir = opendir("/sys/class/input");
+	std::string result = "/dev/input/event0";
+	struct dirent *entry;
+
+	while (dir && (entry = readdir(dir))) {
+		char buf[sizeof(name)] = { 0 };
+		if (strncmp(entry->d_name, "event", 5)) {
+			continue;
+		}
+		const std::string path = std::string("/sys/class/input/")
+		    + entry->d_name + "/device/name";
+		const int fd = open(path.c_str(), O_RDONLY);
+		if (-1 != fd) {
+			const ssize_t len = read(fd, buf, sizeof(buf) - 1);
+			close(fd);
+			if (len > 0 && !strncmp(buf, name, sizeof(name) - 1)) {
+				result = std::string("/dev/input/") + entry->d_name;
+				break;
+			}
+		}
+	}
+	if (dir) {
+		closedir(dir);
+	}
+	return result;
+}
+
+#ifndef __FreeBSD__
+/**
+ * bbapi_gpio_find_line() - lookup a GPIO line by name on all GPIO chips
+ * @name: line name to search for, e.g. BBAPI_PWRFAIL_LINE
+ * @chip: path of the GPIO chip the line belongs to
+ * @offset: offset of the line within @chip
+ */
+static inline bool bbapi_gpio_find_line(const char *name, std::string * chip,
+					uint32_t * offset)
+{
+	for (int i = 0; i < 64; ++i) {
+		char path[32];
+		struct gpiochip_info info;
+
+		snprintf(path, sizeof(path), "/dev/gpiochip%d", i);
+		const int fd = open(path, O_RDONLY | O_CLOEXEC);
+		if (-1 == fd) {
+			continue;
+		}
+		if (!ioctl(fd, GPIO_GET_CHIPINFO_IOCTL, &info)) {
+			for (uint32_t line = 0; line < info.lines; ++line) {
+				struct gpioline_info li;
+				memset(&li, 0, sizeof(li));
+				li.line_offset = line;
+				if (!ioctl(fd, GPIO_GET_LINEINFO_IOCTL, &li)
+				    && !strcmp(name, li.name)) {
+					close(fd);
+					*chip = path;
+					*offset = line;
+					return true;
+				}
+			}
+		}
+		close(fd);
+	}
+	return false;
+}
+
+/**
+ * bbapi_gpio_request_line() - request a GPIO line as input
+ * @consumer: label of the line owner
+ * @eventflags: GPIOEVENT_REQUEST_* edges to report or 0 for a line handle,
+ *              which can only be sampled
+ *
+ * Return: file descriptor of the line or -1 with errno set
+ */
+static inline int bbapi_gpio_request_line(const char *chip, uint32_t offset,
+					  const char *consumer,
+					  uint32_t eventflags)
+{
+	const int fd = open(chip, O_RDONLY | O_CLOEXEC);
+	int result = -1;
+
+	if (-1 == fd) {
+		return -1;
+	}
+
+	if (eventflags) {
+		struct gpioevent_request req;
+		memset(&req, 0, sizeof(req));
+		req.lineoffset = offset;
+		req.handleflags = GPIOHANDLE_REQUEST_INPUT;
+		req.eventflags = eventflags;
+		strncpy(req.consumer_label, consumer,
+			sizeof(req.consumer_label) - 1);
+		if (!ioctl(fd, GPIO_GET_LINEEVENT_IOCTL, &req)) {
+			result = req.fd;
+		}
+	} else {
+		struct gpiohandle_request req;
+		memset(&req, 0, sizeof(req));
+		req.lineoffsets[0] = offset;
+		req.flags = GPIOHANDLE_REQUEST_INPUT;
+		req.lines = 1;
+		strncpy(req.consumer_label, consumer,
+			sizeof(req.consumer_label) - 1);
+		if (!ioctl(fd, GPIO_GET_LINEHANDLE_IOCTL, &req)) {
+			result = req.fd;
+		}
+	}
+
+	const int err = errno;
+	close(fd);
+	errno = err;
+	return result;
+}
+
+/**
+ * bbapi_gpio_read_line() - sample the value of a requested line
+ *
+ * Return: 0 or 1, -1 on error
+ */
+static inline int bbapi_gpio_read_line(int fd)
+{
+	struct gpiohandle_data data;
+
+	if (ioctl(fd, GPIOHANDLE_GET_LINE_VALUES_IOCTL, &data)) {
+		return -1;
+	}
+	return !!data.values[0];
+}
+
+/**
+ * bbapi_gpio_event_ns() - convert a GPIO event timestamp to CLOCK_MONOTONIC
+ *
+ * Kernels before 5.7 stamp events with CLOCK_REALTIME, newer kernels use
+ * CLOCK_MONOTONIC. The event was just read, so the clock closer to the
+ * timestamp is the one used by the kernel.
+ */
+static inline uint64_t bbapi_gpio_event_ns(uint64_t timestamp)
+{
+	const uint64_t mono = bbapi_clock_ns();
+	const uint64_t real = bbapi_clock_ns(CLOCK_REALTIME);
+
+	if (timestamp > mono || mono - timestamp > real - timestamp) {
+		return mono - (real - timestamp);
+	}
+	return timestamp;
+}
+#endif /* #ifndef __FreeBSD__ */
+
+#endif /* #ifndef _BBAPI_CLIENT_H_ */
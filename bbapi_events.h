@@ -0,0 +1,820 @@
+// SPDX-License-Identifier: MIT
+/**
+    C++20 coroutine interface to BBAPI related events
+
+    Tasks wait for events with co_await instead of owning a thread or a
+    polling loop each:
+
+      bbapi::task on_pwrfail(void)
+      {
+              for (;;) {
+                      const bbapi::pwrfail p = co_await bbapi::next_pwrfail();
+                      ...
+              }
+      }
+
+    Awaitable events:
+      next_pwrfail()              rising edge of the 'sups_pwrfail' GPIO
+      next_button()               key event of the CX2100 buttons
+      next_power_supply_uevent()  kernel uevent of SUBSYSTEM=power_supply
+      changed(<value>[, <ms>])    change of a value readable by
+                                  bbapi_find_value(), e.g.
+                                  changed("CXUPS_GETPOWERSTATUS")
+      sleep_for_ms(), sleep_until()  CLOCK_MONOTONIC timers, e.g. to ping
+                                  a watchdog
+
+    Everything is driven by bbapi::loop::get().run(), a single epoll loop
+    in the calling thread. Each event source is opened on first use and
+    shared by all tasks waiting for it. All waiting tasks are resumed in
+    the order they started to wait, each one with its own copy of the
+    event. Events, which occur while no task is waiting, are dropped.
+
+    A waiting task costs its coroutine frame and nothing else: no thread,
+    no file descriptor and no system call while idle. Sources without
+    interrupt, which are the values read through /dev/bbapi and the
+    pwrfail GPIO of chips without edge events, are polled, but only as
+    long as at least one task is waiting for them. A value is read from
+    the loop thread, slow BIOS commands delay all other events for their
+    duration, see 'bbapictl.bin' for the cost of a command.
+
+    Each event carries an 'error' member, 0 or an errno value. Waiting
+    for a source, which failed to open, completes immediately with the
+    error.
+
+    The task type is fire-and-forget: a task starts running when called
+    and frees itself when it returns. This header is not thread-safe,
+    everything has to run in the thread calling loop::run().
+
+    Copyright (C) 2026 Beckhoff Automation GmbH & Co. KG
+*/
+
+#ifndef _BBAPI_EVENTS_H_
+#define _BBAPI_EVENTS_H_
+
+#include "bbapi_client.h"
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <queue>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <linux/input.h>
+#include <linux/netlink.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+
+#define BBAPI_EVENTS_CONSUMER "bbapi_events"
+
+#ifndef BBAPI_EVENTS_PWRFAIL_POLL_US
+#define BBAPI_EVENTS_PWRFAIL_POLL_US 1000
+#endif
+
+#ifndef BBAPI_EVENTS_DEFAULT_PERIOD_MS
+#define BBAPI_EVENTS_DEFAULT_PERIOD_MS 1000
+#endif
+
+namespace bbapi {
+
+/**
+ * struct task - return type of fire-and-forget coroutines
+ *
+ * The coroutine runs until its first co_await when called and its frame
+ * is destroyed when it returns. Exceptions terminate the process.
+ */
+struct task {
+	struct promise_type {
+		task get_return_object(void) {
+			return task();
+		}
+		std::suspend_never initial_suspend(void) noexcept {
+			return std::suspend_never();
+		}
+		std::suspend_never final_suspend(void) noexcept {
+			return std::suspend_never();
+		}
+		void return_void(void) {
+		}
+		void unhandled_exception(void) {
+			std::terminate();
+		}
+	};
+};
+
+/**
+ * struct pwrfail - a power fail detected on the 'sups_pwrfail' GPIO
+ * @error: 0 or errno
+ * @ns: CLOCK_MONOTONIC of the edge, or of the sample which detected it
+ */
+struct pwrfail {
+	int error;
+	uint64_t ns;
+};
+
+/**
+ * struct button - a key event of the CX2100 buttons
+ * @error: 0 or errno
+ * @code: KEY_UP, KEY_DOWN, KEY_LEFT, KEY_RIGHT or KEY_ENTER
+ * @value: 1 pressed, 0 released, 2 auto repeat
+ */
+struct button {
+	int error;
+	uint16_t code;
+	int32_t value;
+};
+
+/**
+ * struct power_supply_uevent - a kernel uevent of a power supply
+ * @error: 0 or errno
+ * @action: e.g. "change", "add" or "remove"
+ * @name: POWER_SUPPLY_NAME, e.g. "bbapi_power"
+ * @env: all KEY=VALUE pairs of the uevent
+ */
+struct power_supply_uevent {
+	int error;
+	std::string action;
+	std::string name;
+	std::vector<std::string> env;
+
+	/**
+	 * get() - lookup a key of the uevent
+	 *
+	 * Return: the value of @key or NULL
+	 */
+	const char *get(const char *key) const {
+		const size_t len = strlen(key);
+		for (size_t i = 0; i < env.size(); ++i) {
+			if (!strncmp(env[i].c_str(), key, len)
+			    && '=' == env[i][len]) {
+				return env[i].c_str() + len + 1;
+			}
+		}
+		return NULL;
+	}
+};
+
+/**
+ * struct value_change - a changed value read through /dev/bbapi
+ * @error: 0 or errno, if the value could not be read
+ * @value: the new value, decoded by bbapi_decode_value()
+ * @previous: the value reported before
+ */
+struct value_change {
+	int error;
+	int64_t value;
+	int64_t previous;
+};
+
+/**
+ * class fd_source - a file descriptor watched by the loop
+ */
+class fd_source {
+public:
+	virtual ~fd_source() {
+	}
+	virtual void on_ready(uint32_t events) = 0;
+};
+
+/**
+ * class loop - the epoll loop resuming all waiting tasks
+ *
+ * A single timerfd serves all timers, the next deadline is the top of a
+ * min-heap.
+ */
+class loop {
+public:
+	static loop &get(void) {
+		static loop instance;
+		return instance;
+	}
+
+	/**
+	 * watch() - dispatch EPOLLIN of @fd to @source until unwatch()
+	 *
+	 * Return: 0 on success, -1 with errno set otherwise
+	 */
+	int watch(int fd, fd_source *source) {
+		struct epoll_event ev;
+
+		memset(&ev, 0, sizeof(ev));
+		ev.events = EPOLLIN;
+		ev.data.ptr = source;
+		return epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &ev);
+	}
+
+	void unwatch(int fd) {
+		epoll_ctl(epoll, EPOLL_CTL_DEL, fd, NULL);
+	}
+
+	/**
+	 * resume_at() - resume @h at CLOCK_MONOTONIC @ns from the loop
+	 */
+	void resume_at(uint64_t ns, std::coroutine_handle<> h) {
+		timers.push(timer {ns, ++timer_seq, h});
+		if (timers.top().seq == timer_seq) {
+			arm(ns);
+		}
+	}
+
+	/**
+	 * run() - dispatch events until stop() is called
+	 *
+	 * Return: 0 after stop(), -1 with errno set on error
+	 */
+	int run(void) {
+		if (-1 == epoll || -1 == timer_fd) {
+			return -1;
+		}
+
+		stopped = false;
+		while (!stopped) {
+			struct epoll_event events[16];
+			const int num = epoll_wait(epoll, events, 16, -1);
+			if (num < 0) {
+				if (EINTR == errno) {
+					continue;
+				}
+				return -1;
+			}
+			for (int i = 0; i < num; ++i) {
+				fd_source *const s =
+				    (fd_source *) events[i].data.ptr;
+				if (s) {
+					s->on_ready(events[i].events);
+				} else {
+					expire();
+				}
+			}
+		}
+		return 0;
+	}
+
+	void stop(void) {
+		stopped = true;
+	}
+
+private:
+	struct timer {
+		uint64_t ns;
+		uint64_t seq;
+		std::coroutine_handle<> h;
+
+		bool operator>(const timer &other) const {
+			return ns != other.ns ? ns > other.ns : seq > other.seq;
+		}
+	};
+
+	int epoll;
+	int timer_fd;
+	bool stopped;
+	uint64_t timer_seq;
+	std::priority_queue<timer, std::vector<timer>,
+	    std::greater<timer> > timers;
+
+	loop(void) : stopped(false), timer_seq(0) {
+		struct epoll_event ev;
+
+		epoll = epoll_create1(EPOLL_CLOEXEC);
+		timer_fd = timerfd_create(CLOCK_MONOTONIC,
+					  TFD_NONBLOCK | TFD_CLOEXEC);
+		memset(&ev, 0, sizeof(ev));
+		ev.events = EPOLLIN;
+		ev.data.ptr = NULL;
+		if (-1 != epoll && -1 != timer_fd) {
+			epoll_ctl(epoll, EPOLL_CTL_ADD, timer_fd, &ev);
+		}
+	}
+
+	~loop() {
+		close(timer_fd);
+		close(epoll);
+	}
+
+	/**
+	 * arm() - set the timerfd to an absolute deadline, 0 disarms
+	 *
+	 * A deadline in the past expires immediately.
+	 */
+	void arm(uint64_t ns) {
+		struct itimerspec spec;
+
+		memset(&spec, 0, sizeof(spec));
+		if (ns) {
+			spec.it_value.tv_sec = ns / 1000000000ULL;
+			spec.it_value.tv_nsec = ns % 1000000000ULL;
+			if (!spec.it_value.tv_sec && !spec.it_value.tv_nsec) {
+				spec.it_value.tv_nsec = 1;
+			}
+		}
+		timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &spec, NULL);
+	}
+
+	/**
+	 * expire() - resume all tasks with an expired timer
+	 *
+	 * Expired timers are collected before resuming, a task sleeping
+	 * again with a deadline in the past runs in the next iteration.
+	 */
+	void expire(void) {
+		uint64_t expirations;
+		std::vector<std::coroutine_handle<> > due;
+		const uint64_t now = bbapi_clock_ns();
+
+		if (read(timer_fd, &expirations, sizeof(expirations)) < 0) {
+			// spurious wakeup, the heap decides
+		}
+		while (!timers.empty() && timers.top().ns <= now) {
+			due.push_back(timers.top().h);
+			timers.pop();
+		}
+		for (size_t i = 0; i < due.size(); ++i) {
+			due[i].resume();
+		}
+		arm(timers.empty() ? 0 : timers.top().ns);
+	}
+};
+
+/**
+ * struct sleep_awaiter - awaitable returned by sleep_until()
+ */
+struct sleep_awaiter {
+	uint64_t ns;
+
+	bool await_ready(void) const {
+		return false;
+	}
+	void await_suspend(std::coroutine_handle<> h) const {
+		loop::get().resume_at(ns, h);
+	}
+	void await_resume(void) const {
+	}
+};
+
+/**
+ * sleep_until() - wait until CLOCK_MONOTONIC @ns (see bbapi_clock_ns())
+ */
+inline sleep_awaiter sleep_until(uint64_t ns)
+{
+	return sleep_awaiter {ns};
+}
+
+inline sleep_awaiter sleep_for_ms(uint64_t ms)
+{
+	return sleep_until(bbapi_clock_ns() + ms * 1000000ULL);
+}
+
+/**
+ * class event - broadcast of a value to all waiting tasks
+ *
+ * The waiters are an intrusive list of the awaiters, which live in the
+ * frames of the suspended tasks. @on_first_waiter is called when the
+ * list becomes non-empty, polling sources use it to start polling.
+ */
+template <typename T> class event {
+public:
+	struct awaiter {
+		event *e;
+		awaiter *next;
+		std::coroutine_handle<> h;
+		T value;
+
+		bool await_ready(void) {
+			if (e->error) {
+				value.error = e->error;
+				return true;
+			}
+			return false;
+		}
+		void await_suspend(std::coroutine_handle<> h) {
+			this->h = h;
+			e->push(this);
+		}
+		T await_resume(void) {
+			return value;
+		}
+	};
+
+	int error;
+	std::function<void(void)> on_first_waiter;
+
+	event(void) : error(0), head(NULL), tail(NULL) {
+	}
+
+	awaiter wait(void) {
+		return awaiter {this, NULL, std::coroutine_handle<>(), T()};
+	}
+
+	bool waiting(void) const {
+		return head;
+	}
+
+	/**
+	 * fire() - resume all current waiters with a copy of @value
+	 *
+	 * Tasks waiting again while resumed wait for the next fire().
+	 */
+	void fire(const T &value) {
+		awaiter *w = head;
+
+		head = tail = NULL;
+		while (w) {
+			awaiter *const next = w->next;
+			w->value = value;
+			w->h.resume();
+			w = next;
+		}
+	}
+
+	/**
+	 * fail() - resume all waiters with @err, later waits fail immediately
+	 */
+	void fail(int err) {
+		T value = T();
+
+		error = err;
+		value.error = err;
+		fire(value);
+	}
+
+private:
+	awaiter *head;
+	awaiter *tail;
+
+	void push(awaiter *w) {
+		const bool first = !head;
+
+		w->next = NULL;
+		if (tail) {
+			tail->next = w;
+		} else {
+			head = w;
+		}
+		tail = w;
+		if (first && on_first_waiter) {
+			on_first_waiter();
+		}
+	}
+};
+
+namespace detail {
+
+/**
+ * set_nonblock() - switch a file descriptor to non blocking mode
+ *
+ * Return: @fd
+ */
+inline int set_nonblock(int fd)
+{
+	if (-1 != fd) {
+		fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+	}
+	return fd;
+}
+
+/**
+ * class pwrfail_source - rising edges of the 'sups_pwrfail' GPIO
+ *
+ * Uses edge events if the GPIO chip supports them, else the line is
+ * sampled every BBAPI_EVENTS_PWRFAIL_POLL_US while tasks are waiting.
+ */
+class pwrfail_source : public fd_source {
+public:
+	event<pwrfail> fired;
+
+	static pwrfail_source &get(void) {
+		static pwrfail_source instance;
+		return instance;
+	}
+
+	void on_ready(uint32_t /* events */) {
+		struct gpioevent_data ev;
+
+		while (sizeof(ev) == read(fd, &ev, sizeof(ev))) {
+			if (GPIOEVENT_EVENT_RISING_EDGE == ev.id) {
+				fired.fire(pwrfail {0, bbapi_gpio_event_ns(ev.timestamp)});
+			}
+		}
+		if (EAGAIN != errno) {
+			loop::get().unwatch(fd);
+			fired.fail(errno);
+		}
+	}
+
+private:
+	int fd;
+	bool polling;
+
+	pwrfail_source(void) : fd(-1), polling(false) {
+		std::string chip;
+		uint32_t offset;
+
+		if (!bbapi_gpio_find_line(BBAPI_PWRFAIL_LINE, &chip, &offset)) {
+			fired.error = ENOENT;
+			return;
+		}
+
+		fd = set_nonblock(bbapi_gpio_request_line(chip.c_str(), offset,
+							  BBAPI_EVENTS_CONSUMER,
+							  GPIOEVENT_REQUEST_RISING_EDGE));
+		if (-1 != fd) {
+			if (loop::get().watch(fd, this)) {
+				fired.error = errno;
+			}
+			return;
+		}
+
+		fd = bbapi_gpio_request_line(chip.c_str(), offset,
+					     BBAPI_EVENTS_CONSUMER, 0);
+		if (-1 == fd) {
+			fired.error = errno;
+			return;
+		}
+		fired.on_first_waiter = [this] {
+			if (!polling) {
+				poll(this);
+			}
+		};
+	}
+
+	static task poll(pwrfail_source *s) {
+		int last = bbapi_gpio_read_line(s->fd);
+
+		s->polling = true;
+		while (s->fired.waiting()) {
+			co_await sleep_until(bbapi_clock_ns() +
+					     BBAPI_EVENTS_PWRFAIL_POLL_US *
+					     1000ULL);
+			const int now = bbapi_gpio_read_line(s->fd);
+			if (now < 0) {
+				s->fired.fire(pwrfail {errno, 0});
+			} else if (now && !last) {
+				s->fired.fire(pwrfail {0, bbapi_clock_ns()});
+			}
+			last = now;
+		}
+		s->polling = false;
+	}
+};
+
+/**
+ * class button_source - key events of the bbapi_button input device
+ */
+class button_source : public fd_source {
+public:
+	event<button> fired;
+
+	static button_source &get(void) {
+		static button_source instance;
+		return instance;
+	}
+
+	void on_ready(uint32_t /* events */) {
+		struct input_event ev[16];
+		ssize_t len;
+
+		while ((len = read(fd, ev, sizeof(ev))) > 0) {
+			for (size_t i = 0; i < len / sizeof(ev[0]); ++i) {
+				if (EV_KEY == ev[i].type) {
+					fired.fire(button {0, ev[i].code, ev[i].value});
+				}
+			}
+		}
+		if (EAGAIN != errno) {
+			loop::get().unwatch(fd);
+			fired.fail(errno);
+		}
+	}
+
+private:
+	int fd;
+
+	button_source(void) {
+		const std::string path = bbapi_find_button_device();
+
+		fd = open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+		if (-1 == fd || loop::get().watch(fd, this)) {
+			fired.error = errno;
+		}
+	}
+};
+
+/**
+ * class uevent_source - kernel uevents of SUBSYSTEM=power_supply
+ */
+class uevent_source : public fd_source {
+public:
+	event<power_supply_uevent> fired;
+
+	static uevent_source &get(void) {
+		static uevent_source instance;
+		return instance;
+	}
+
+	void on_ready(uint32_t /* events */) {
+		char buf[8192];
+		ssize_t len;
+
+		while ((len = recv(fd, buf, sizeof(buf) - 1, 0)) > 0) {
+			buf[len] = 0;
+			dispatch(buf, buf + len);
+		}
+		if (EAGAIN != errno) {
+			loop::get().unwatch(fd);
+			fired.fail(errno);
+		}
+	}
+
+private:
+	int fd;
+
+	uevent_source(void) {
+		struct sockaddr_nl addr;
+
+		memset(&addr, 0, sizeof(addr));
+		addr.nl_family = AF_NETLINK;
+		addr.nl_groups = 1;	// kernel events, not the ones of udev
+		fd = socket(AF_NETLINK,
+			    SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+			    NETLINK_KOBJECT_UEVENT);
+		if (-1 == fd || bind(fd, (struct sockaddr *)&addr, sizeof(addr))
+		    || loop::get().watch(fd, this)) {
+			fired.error = errno;
+		}
+	}
+
+	/**
+	 * dispatch() - parse "<action>@<devpath>\0KEY=VALUE\0..."
+	 */
+	void dispatch(const char *p, const char *end) {
+		const char *const at = strchr(p, '@');
+		power_supply_uevent u;
+		bool match = false;
+
+		if (!at) {
+			return;
+		}
+		u.error = 0;
+		u.action.assign(p, at - p);
+		for (p += strlen(p) + 1; p < end; p += strlen(p) + 1) {
+			u.env.push_back(p);
+			if (!strcmp(p, "SUBSYSTEM=power_supply")) {
+				match = true;
+			} else if (!strncmp(p, "POWER_SUPPLY_NAME=", 18)) {
+				u.name = p + 18;
+			}
+		}
+		if (match) {
+			fired.fire(u);
+		}
+	}
+};
+
+/**
+ * bbapi_fd() - /dev/bbapi, opened once for all value sources
+ */
+inline int bbapi_fd(void)
+{
+	static const int fd = open(BBAPI_DEVICE, O_RDWR | O_CLOEXEC);
+	return fd;
+}
+
+/**
+ * class value_source - a value polled through /dev/bbapi while awaited
+ *
+ * The first sample is the reference, a change is reported relative to
+ * the last reported value. So a task waiting again after doing something
+ * else doesn't miss a change in between.
+ */
+class value_source {
+public:
+	event<value_change> fired;
+	uint64_t period_ns;
+
+	value_source(const struct bbapi_value &v, uint64_t period)
+	: period_ns(period), value(v), valid(false), last(0), polling(false) {
+		value.name = NULL;	// may point into the caller's buffer
+		if (-1 == bbapi_fd()) {
+			fired.error = errno;
+			return;
+		}
+		fired.on_first_waiter = [this] {
+			if (!polling) {
+				poll(this);
+			}
+		};
+	}
+
+private:
+	struct bbapi_value value;
+	bool valid;
+	int64_t last;
+	bool polling;
+
+	/**
+	 * poll() - sample the value while tasks are waiting
+	 *
+	 * The first sample is taken in the next loop iteration, not while
+	 * the first waiter is still suspending.
+	 */
+	static task poll(value_source *s) {
+		uint64_t next = bbapi_clock_ns();
+
+		s->polling = true;
+		while (s->fired.waiting()) {
+			int64_t now;
+
+			co_await sleep_until(next);
+			next = bbapi_clock_ns() + s->period_ns;
+			if (bbapi_read_value(bbapi_fd(), &s->value, &now)) {
+				s->fired.fire(value_change {errno, 0, s->last});
+			} else if (!s->valid) {
+				s->valid = true;
+				s->last = now;
+			} else if (now != s->last) {
+				const int64_t previous = s->last;
+				s->last = now;
+				s->fired.fire(value_change {0, now, previous});
+			}
+		}
+		s->polling = false;
+	}
+};
+
+/**
+ * value_source_get() - lookup or create the source of a value
+ *
+ * Return: the shared source or NULL if @name is unknown
+ */
+inline value_source *value_source_get(const char *name, uint64_t period_ns)
+{
+	static std::map<uint64_t, std::unique_ptr<value_source> > sources;
+	struct bbapi_value v;
+
+	if (!bbapi_find_value(name, &v)) {
+		return NULL;
+	}
+
+	std::unique_ptr<value_source> &s =
+	    sources[(uint64_t) v.group << 32 | v.offset];
+	if (!s) {
+		s.reset(new value_source(v, period_ns));
+	} else if (period_ns < s->period_ns) {
+		s->period_ns = period_ns;
+	}
+	return s.get();
+}
+
+}				/* namespace detail */
+
+/**
+ * next_pwrfail() - wait for the next power fail of the S-UPS
+ */
+inline event<pwrfail>::awaiter next_pwrfail(void)
+{
+	return detail::pwrfail_source::get().fired.wait();
+}
+
+/**
+ * next_button() - wait for the next key event of the CX2100 buttons
+ */
+inline event<button>::awaiter next_button(void)
+{
+	return detail::button_source::get().fired.wait();
+}
+
+/**
+ * next_power_supply_uevent() - wait for the next power supply uevent
+ */
+inline event<power_supply_uevent>::awaiter next_power_supply_uevent(void)
+{
+	return detail::uevent_source::get().fired.wait();
+}
+
+/**
+ * changed() - wait for the next change of a value
+ * @name: name accepted by bbapi_find_value(), e.g. "CXUPS_GETPOWERSTATUS"
+ * @period_ms: poll period, the shortest one requested for a value is used
+ *
+ * Unknown values fail immediately with EINVAL.
+ */
+inline event<value_change>::awaiter changed(const char *name,
+					    uint64_t period_ms =
+					    BBAPI_EVENTS_DEFAULT_PERIOD_MS)
+{
+	static event<value_change> unknown;
+	detail::value_source *const s =
+	    detail::value_source_get(name, period_ms * 1000000ULL);
+
+	if (!s) {
+		unknown.error = EINVAL;
+		return unknown.wait();
+	}
+	return s->fired.wait();
+}
+
+}				/* namespace bbapi */
+#endif /* #ifndef _BBAPI_EVENTS_H_ */
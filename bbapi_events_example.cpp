@@ -0,0 +1,213 @@
+// SPDX-License-Identifier: MIT
+/**
+    Example for the coroutine event interface of bbapi_events.h
+
+    usage: bbapi_events_example [-p <ms>] [-w <s>] [-n <tasks>] [<value>]...
+
+    One task per event source logs power fails, CX2100 button events and
+    power supply uevents to stdout. Another task per <value> (default:
+    CXUPS_GETPOWERSTATUS) logs its changes, polled every -p milliseconds
+    while awaited. With -w /dev/watchdog is opened and pinged every <s>
+    seconds from a task, too. -n starts <tasks> additional idle tasks
+    waiting for each source, to show that waiting costs nothing.
+
+    All tasks run in a single thread on the epoll loop of bbapi_events.h.
+
+    Copyright (C) 2026 Beckhoff Automation GmbH & Co. KG
+*/
+
+#include "bbapi_events.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <linux/watchdog.h>
+
+static void log_line(const char *source, const char *fmt, ...)
+    __attribute__ ((format(printf, 2, 3)));
+
+static void log_line(const char *source, const char *fmt, ...)
+{
+	const uint64_t now = bbapi_clock_ns();
+	va_list args;
+
+	printf("%llu.%06llu %-10s ", (unsigned long long)(now / 1000000000ULL),
+	       (unsigned long long)(now % 1000000000ULL / 1000), source);
+	va_start(args, fmt);
+	vprintf(fmt, args);
+	va_end(args);
+	printf("\n");
+	fflush(stdout);
+}
+
+static bbapi::task log_pwrfail(void)
+{
+	for (;;) {
+		const bbapi::pwrfail p = co_await bbapi::next_pwrfail();
+		if (p.error) {
+			log_line("pwrfail", "%s", strerror(p.error));
+			co_return;
+		}
+		log_line("pwrfail", "power fail %llu us ago",
+			 (unsigned long long)(bbapi_clock_ns() - p.ns) / 1000);
+	}
+}
+
+static bbapi::task log_button(void)
+{
+	for (;;) {
+		const bbapi::button b = co_await bbapi::next_button();
+		if (b.error) {
+			log_line("button", "%s", strerror(b.error));
+			co_return;
+		}
+		log_line("button", "code: %u value: %d", b.code, b.value);
+	}
+}
+
+static bbapi::task log_uevent(void)
+{
+	for (;;) {
+		const bbapi::power_supply_uevent u =
+		    co_await bbapi::next_power_supply_uevent();
+		if (u.error) {
+			log_line("uevent", "%s", strerror(u.error));
+			co_return;
+		}
+		const char *const status = u.get("POWER_SUPPLY_STATUS");
+		log_line("uevent", "%s %s status: %s", u.action.c_str(),
+			 u.name.c_str(), status ? status : "-");
+	}
+}
+
+static bbapi::task log_changes(const char *name, uint64_t period_ms)
+{
+	for (;;) {
+		const bbapi::value_change c =
+		    co_await bbapi::changed(name, period_ms);
+		if (c.error) {
+			log_line(name, "%s", strerror(c.error));
+			co_return;
+		}
+		log_line(name, "%lld -> %lld", (long long)c.previous,
+			 (long long)c.value);
+	}
+}
+
+static bbapi::task ping_watchdog(int fd, uint64_t period_s)
+{
+	uint64_t next = bbapi_clock_ns();
+
+	for (;;) {
+		if (ioctl(fd, WDIOC_KEEPALIVE, 0)) {
+			log_line("watchdog", "%s", strerror(errno));
+			co_return;
+		}
+		next += period_s * 1000000000ULL;
+		co_await bbapi::sleep_until(next);
+	}
+}
+
+static bbapi::task idle_pwrfail(uint64_t *count)
+{
+	for (;;) {
+		if ((co_await bbapi::next_pwrfail()).error) {
+			co_return;
+		}
+		++*count;
+	}
+}
+
+static bbapi::task idle_button(uint64_t *count)
+{
+	for (;;) {
+		if ((co_await bbapi::next_button()).error) {
+			co_return;
+		}
+		++*count;
+	}
+}
+
+static bbapi::task idle_changes(const char *name, uint64_t period_ms,
+				uint64_t *count)
+{
+	for (;;) {
+		if ((co_await bbapi::changed(name, period_ms)).error) {
+			co_return;
+		}
+		++*count;
+	}
+}
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr,
+		"usage: %s [-p <ms>] [-w <s>] [-n <tasks>] [<value>]...\n",
+		argv0);
+	exit(-1);
+}
+
+int main(int argc, char *argv[])
+{
+	std::vector<const char *> values;
+	uint64_t period_ms = BBAPI_EVENTS_DEFAULT_PERIOD_MS;
+	uint64_t watchdog_s = 0;
+	unsigned long idle = 0;
+	uint64_t resumed = 0;
+	int opt;
+
+	while (-1 != (opt = getopt(argc, argv, "p:w:n:h"))) {
+		switch (opt) {
+		case 'p':
+			period_ms = strtoull(optarg, NULL, 0);
+			break;
+		case 'w':
+			watchdog_s = strtoull(optarg, NULL, 0);
+			break;
+		case 'n':
+			idle = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	for (int i = optind; i < argc; ++i) {
+		values.push_back(argv[i]);
+	}
+	if (values.empty()) {
+		values.push_back("CXUPS_GETPOWERSTATUS");
+	}
+	if (!period_ms) {
+		usage(argv[0]);
+	}
+
+	log_pwrfail();
+	log_button();
+	log_uevent();
+	for (size_t i = 0; i < values.size(); ++i) {
+		log_changes(values[i], period_ms);
+	}
+
+	if (watchdog_s) {
+		const int fd = open("/dev/watchdog", O_WRONLY | O_CLOEXEC);
+		if (-1 == fd) {
+			perror("open /dev/watchdog");
+			return -1;
+		}
+		ping_watchdog(fd, watchdog_s);
+	}
+
+	for (unsigned long i = 0; i < idle; ++i) {
+		idle_pwrfail(&resumed);
+		idle_button(&resumed);
+		for (size_t v = 0; v < values.size(); ++v) {
+			idle_changes(values[v], period_ms, &resumed);
+		}
+	}
+
+	if (bbapi::loop::get().run()) {
+		perror("bbapi::loop::run()");
+		return -1;
+	}
+	return 0;
+}
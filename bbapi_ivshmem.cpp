@@ -0,0 +1,364 @@
+// SPDX-License-Identifier: MIT
+/**
+    Publish the board sensors to KVM guests through ivshmem
+
+    usage: bbapi_ivshmem [-r <Hz>] [-f <file>] [<value>]...
+           bbapi_ivshmem -d [<file>]
+
+    The host samples the values with -r Hz (default: 10) through
+    /dev/bbapi and writes them, together with the state of the
+    'sups_pwrfail' GPIO, to the shared memory file -f (default:
+    BBAPI_IVSHMEM_FILE). Without <value> all CXPWRSUPP, CXUPS and SUPS
+    values and all used SYSTEM sensors are published, which could be read
+    at startup. Values are read as bulk requests, so the sampling doesn't
+    delay interactive users of the BIOS.
+
+    QEMU maps the file into guests as ivshmem-plain device (see
+    bbapi_ivshmem.h). A guest reads the values from memory, without BIOS
+    call and without VM exit. -d dumps the shared memory, it searches the
+    ivshmem PCI device in a guest and reads the file given on the host.
+
+    Copyright (C) 2026 Beckhoff Automation GmbH & Co. KG
+*/
+
+#include "bbapi_client.h"
+#include "bbapi_ivshmem.h"
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define CONSUMER "bbapi_ivshmem"
+#define DEFAULT_RATE 10
+
+static_assert(sizeof(struct bbapi_ivshmem) <= BBAPI_IVSHMEM_SIZE,
+	      "struct bbapi_ivshmem exceeds BBAPI_IVSHMEM_SIZE");
+
+static volatile sig_atomic_t g_stop;
+
+static void on_signal(int sig)
+{
+	g_stop = 1;
+}
+
+static void snapshot_write_begin(struct bbapi_ivshmem *shm)
+{
+	__atomic_store_n(&shm->snapshot.seq, shm->snapshot.seq | 1,
+			 __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void snapshot_write_end(struct bbapi_ivshmem *shm)
+{
+	__atomic_store_n(&shm->snapshot.seq, shm->snapshot.seq + 1,
+			 __ATOMIC_RELEASE);
+}
+
+/**
+ * create_shm() - map the shared memory file for writing
+ *
+ * An existing file is not cleared, QEMU may already map it into guests.
+ * The sequence counter is continued, so readers never see it go back.
+ * Symlinks and files not owned by us are refused, /dev/shm is world
+ * writable and we shall not truncate or fill someone else's file.
+ *
+ * Return: mapping or NULL with errno set
+ */
+static struct bbapi_ivshmem *create_shm(const char *path)
+{
+	const int fd = open(path, O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC,
+			    0644);
+	struct stat st;
+	void *shm;
+
+	if (-1 == fd) {
+		return NULL;
+	}
+	if (fstat(fd, &st)) {
+		const int err = errno;
+		close(fd);
+		errno = err;
+		return NULL;
+	}
+	if (!S_ISREG(st.st_mode) || st.st_uid != geteuid()) {
+		close(fd);
+		errno = EPERM;
+		return NULL;
+	}
+	if (ftruncate(fd, BBAPI_IVSHMEM_SIZE)) {
+		const int err = errno;
+		close(fd);
+		errno = err;
+		return NULL;
+	}
+	shm = mmap(NULL, BBAPI_IVSHMEM_SIZE, PROT_READ | PROT_WRITE,
+		   MAP_SHARED, fd, 0);
+	close(fd);
+	if (MAP_FAILED == shm) {
+		return NULL;
+	}
+	return (struct bbapi_ivshmem *)shm;
+}
+
+/**
+ * open_pwrfail() - request the 'sups_pwrfail' GPIO line to sample it
+ *
+ * Return: file descriptor of the line or -1 if the board has none
+ */
+static int open_pwrfail(void)
+{
+	std::string chip;
+	uint32_t offset;
+
+	if (!bbapi_gpio_find_line(BBAPI_PWRFAIL_LINE, &chip, &offset)) {
+		return -1;
+	}
+	return bbapi_gpio_request_line(chip.c_str(), offset, CONSUMER, 0);
+}
+
+static int32_t read_pwrfail(int fd)
+{
+	return -1 == fd ? -1 : bbapi_gpio_read_line(fd);
+}
+
+/**
+ * read_value() - sample one value as bulk request
+ *
+ * Return: 0 on success, errno otherwise
+ */
+static int read_value(int fd, const struct bbapi_value *v, int64_t * result)
+{
+	uint8_t raw[sizeof(SENSORINFO)];
+
+	if (bbapi_ioctl_read_bulk(fd, v->group, v->offset, raw, v->size)) {
+		return errno;
+	}
+	*result = bbapi_decode_value(v, raw);
+	return 0;
+}
+
+/**
+ * struct published - the values to publish
+ * @desc: description to read a value, without name
+ * @entries: the values as written to the shared memory
+ */
+struct published {
+	std::vector < struct bbapi_value >desc;
+	std::vector < struct bbapi_ivshmem_value >entries;
+};
+
+static bool add_value(struct published *p, const struct bbapi_value *v)
+{
+	struct bbapi_ivshmem_value entry;
+
+	if (p->entries.size() >= BBAPI_IVSHMEM_MAX_VALUES) {
+		return false;
+	}
+	memset(&entry, 0, sizeof(entry));
+	strncpy(entry.name, v->name, sizeof(entry.name) - 1);
+	strncpy(entry.unit, v->unit, sizeof(entry.unit) - 1);
+	entry.group = v->group;
+	entry.offset = v->offset;
+	p->entries.push_back(entry);
+	p->desc.push_back(*v);
+	p->desc.back().name = NULL;	// may point to a temporary
+	return true;
+}
+
+/**
+ * probe_values() - collect all values of the power groups and sensors,
+ * which can be read on this board
+ */
+static void probe_values(int fd, struct published *p)
+{
+	static const uint32_t groups[] = {
+		BIOSIGRP_CXPWRSUPP, BIOSIGRP_CXUPS, BIOSIGRP_SUPS,
+	};
+	uint32_t num_sensors;
+	int64_t dummy;
+
+	for (size_t g = 0; g < sizeof(groups) / sizeof(groups[0]); ++g) {
+		for (size_t i = 0; i < BBAPI_NUM_VALUES; ++i) {
+			const struct bbapi_value *const v = &BBAPI_VALUES[i];
+			if (groups[g] == v->group && !read_value(fd, v, &dummy)) {
+				add_value(p, v);
+			}
+		}
+	}
+
+	if (bbapi_ioctl_read(fd, BIOSIGRP_SYSTEM,
+			     BIOSIOFFS_SYSTEM_COUNT_SENSORS, &num_sensors,
+			     sizeof(num_sensors))) {
+		return;
+	}
+	for (uint32_t i = BIOSIOFFS_SYSTEM_SENSOR_MIN; i <= num_sensors; ++i) {
+		const std::string name = BBAPI_SENSOR_PREFIX + std::to_string(i);
+		struct bbapi_value v;
+		SENSORINFO sensor;
+
+		if (!bbapi_find_value(name.c_str(), &v)
+		    || bbapi_ioctl_read(fd, v.group, v.offset, &sensor,
+					sizeof(sensor))
+		    || INFOVALUE_STATUS_UNUSED == sensor.readVal.status) {
+			continue;
+		}
+		add_value(p, &v);
+	}
+}
+
+static void dump(const char *path)
+{
+	const struct bbapi_ivshmem *const shm = bbapi_ivshmem_map(path);
+	struct bbapi_ivshmem_snapshot snap;
+
+	if (!shm) {
+		perror(path ? path : "ivshmem PCI device");
+		exit(-1);
+	}
+	if (bbapi_ivshmem_read(shm, &snap)) {
+		perror("bbapi_ivshmem_read()");
+		exit(-1);
+	}
+
+	printf("pid: %d samples: %llu period: %u us age: %lld ms pwrfail: %d\n",
+	       shm->pid, (unsigned long long)snap.samples, snap.period_us,
+	       (long long)(bbapi_clock_ns(CLOCK_REALTIME) -
+			   snap.realtime_ns) / 1000000, snap.pwrfail);
+	printf("%-32s %12s %-5s %s\n", "value", "", "unit", "error");
+	for (uint32_t i = 0; i < snap.num_values; ++i) {
+		const struct bbapi_ivshmem_value &v = snap.values[i];
+		printf("%-32.32s %12lld %-5.8s %s\n", v.name,
+		       (long long)v.value, v.unit,
+		       v.error ? strerror(v.error) : "");
+	}
+}
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr,
+		"usage: %s [-r <Hz>] [-f <file>] [<value>]...\n"
+		"       %s -d [<file>]\n", argv0, argv0);
+	exit(-1);
+}
+
+int main(int argc, char *argv[])
+{
+	struct published values;
+	const char *path = BBAPI_IVSHMEM_FILE;
+	unsigned long rate = DEFAULT_RATE;
+	bool do_dump = false;
+	int opt;
+
+	while (-1 != (opt = getopt(argc, argv, "r:f:dh"))) {
+		switch (opt) {
+		case 'r':
+			rate = strtoul(optarg, NULL, 0);
+			break;
+		case 'f':
+			path = optarg;
+			break;
+		case 'd':
+			do_dump = true;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+
+	if (do_dump) {
+		dump(optind < argc ? argv[optind] : NULL);
+		return 0;
+	}
+
+	if (!rate || rate > 1000) {
+		usage(argv[0]);
+	}
+
+	const int fd = open(BBAPI_DEVICE, O_RDWR | O_CLOEXEC);
+	if (-1 == fd) {
+		perror(BBAPI_DEVICE);
+		return -1;
+	}
+
+	for (int i = optind; i < argc; ++i) {
+		struct bbapi_value v;
+		if (!bbapi_find_value(argv[i], &v)) {
+			fprintf(stderr, "unknown value '%s'\n", argv[i]);
+			return -1;
+		}
+		if (!add_value(&values, &v)) {
+			fprintf(stderr, "more than %d values\n",
+				BBAPI_IVSHMEM_MAX_VALUES);
+			return -1;
+		}
+	}
+	if (values.entries.empty()) {
+		probe_values(fd, &values);
+	}
+
+	struct bbapi_ivshmem *const shm = create_shm(path);
+	if (!shm) {
+		perror(path);
+		return -1;
+	}
+
+	const int pwrfail = open_pwrfail();
+	const uint64_t period_ns = 1000000000ULL / rate;
+
+	snapshot_write_begin(shm);
+	memset(&shm->snapshot.pwrfail, 0,
+	       sizeof(shm->snapshot) - sizeof(shm->snapshot.seq));
+	shm->snapshot.pwrfail = read_pwrfail(pwrfail);
+	shm->snapshot.period_us = period_ns / 1000;
+	shm->snapshot.num_values = values.entries.size();
+	memcpy(shm->snapshot.values, values.entries.data(),
+	       values.entries.size() * sizeof(values.entries[0]));
+	shm->snapshot.realtime_ns = bbapi_clock_ns(CLOCK_REALTIME);
+	snapshot_write_end(shm);
+	shm->version = BBAPI_IVSHMEM_VERSION;
+	shm->size = sizeof(*shm);
+	shm->pid = getpid();
+	__atomic_store_n(&shm->magic, BBAPI_IVSHMEM_MAGIC, __ATOMIC_RELEASE);
+
+	signal(SIGINT, on_signal);
+	signal(SIGTERM, on_signal);
+
+	fprintf(stderr, "publishing %zu values at %lu Hz to %s\n",
+		values.entries.size(), rate, path);
+
+	struct timespec next;
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	while (!g_stop) {
+		/* sample outside of the write section, BIOS calls are slow */
+		for (size_t i = 0; i < values.entries.size(); ++i) {
+			struct bbapi_ivshmem_value &e = values.entries[i];
+			int64_t value;
+
+			e.error = read_value(fd, &values.desc[i], &value);
+			if (!e.error) {
+				e.value = value;
+			}
+		}
+		const int32_t state = read_pwrfail(pwrfail);
+
+		snapshot_write_begin(shm);
+		shm->snapshot.pwrfail = state;
+		memcpy(shm->snapshot.values, values.entries.data(),
+		       values.entries.size() * sizeof(values.entries[0]));
+		shm->snapshot.realtime_ns = bbapi_clock_ns(CLOCK_REALTIME);
+		++shm->snapshot.samples;
+		snapshot_write_end(shm);
+
+		next.tv_nsec += period_ns;
+		while (next.tv_nsec >= 1000000000) {
+			next.tv_nsec -= 1000000000;
+			++next.tv_sec;
+		}
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+	}
+
+	shm->pid = 0;
+	return 0;
+}
@@ -0,0 +1,262 @@
+// SPDX-License-Identifier: MIT
+/**
+    Shared memory layout of bbapi_ivshmem and the reader API for KVM guests
+
+    bbapi_ivshmem samples the board sensors on the host and publishes them
+    in BBAPI_IVSHMEM_FILE. QEMU passes that file to guests as ivshmem-plain
+    PCI device, the guest finds the same layout in BAR 2:
+
+      qemu-system-x86_64 ... \
+        -object memory-backend-file,id=bbapi,share=on,mem-path=/dev/shm/bbapi_ivshmem,size=16K \
+        -device ivshmem-plain,memdev=bbapi
+
+    Guests neither call the BIOS nor cause a VM exit to read the values:
+
+      const struct bbapi_ivshmem *shm = bbapi_ivshmem_map(NULL);
+      struct bbapi_ivshmem_snapshot snap;
+      if (shm && !bbapi_ivshmem_read(shm, &snap)) {
+              const struct bbapi_ivshmem_value *v =
+                  bbapi_ivshmem_find(&snap, "CXPWRSUPP_GET24VOLT");
+              ...
+      }
+
+    The snapshot is protected by a sequence counter, readers copy it and
+    retry if the host updated it in between. This header depends on libc
+    only, to be usable in guests without the rest of this repository.
+
+    Copyright (C) 2026 Beckhoff Automation GmbH & Co. KG
+*/
+
+#ifndef _BBAPI_IVSHMEM_H_
+#define _BBAPI_IVSHMEM_H_
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#define BBAPI_IVSHMEM_FILE "/dev/shm/bbapi_ivshmem"
+#define BBAPI_IVSHMEM_MAGIC 0x6d687362	/* "bshm" */
+#define BBAPI_IVSHMEM_VERSION 1
+#define BBAPI_IVSHMEM_SIZE 16384	/* ivshmem requires a power of two */
+#define BBAPI_IVSHMEM_MAX_VALUES 192
+#define BBAPI_IVSHMEM_MAX_NAME 32
+#define BBAPI_IVSHMEM_MAX_UNIT 8
+#define BBAPI_IVSHMEM_RETRIES 1000
+
+#define BBAPI_IVSHMEM_PCI_VENDOR 0x1af4	/* Red Hat, Inc. */
+#define BBAPI_IVSHMEM_PCI_DEVICE 0x1110	/* Inter-VM shared memory */
+
+/**
+ * struct bbapi_ivshmem_value - one sampled value
+ * @name: identifier as accepted by bbapi_find_value() on the host
+ * @unit: unit of @value
+ * @group: IndexGroup
+ * @offset: IndexOffset
+ * @value: decoded value, the current reading (readVal) for SENSORINFOs
+ * @error: 0 or the errno of the last read, @value is the last good one
+ */
+struct bbapi_ivshmem_value {
+	char name[BBAPI_IVSHMEM_MAX_NAME];
+	char unit[BBAPI_IVSHMEM_MAX_UNIT];
+	uint32_t group;
+	uint32_t offset;
+	int64_t value;
+	int32_t error;
+	uint32_t reserved;
+};
+
+/**
+ * struct bbapi_ivshmem_snapshot - all values of one sampling period
+ * @seq: sequence counter, odd while the host updates the snapshot
+ * @pwrfail: state of the 'sups_pwrfail' GPIO, 1 power fail, 0 power good,
+ *           -1 if the board has none
+ * @samples: number of completed sampling periods
+ * @realtime_ns: host CLOCK_REALTIME at the end of the last period
+ * @period_us: sampling period
+ * @num_values: number of valid entries in @values
+ * @values: the sampled values
+ *
+ * A guest detects a stopped host by @samples not advancing.
+ */
+struct bbapi_ivshmem_snapshot {
+	uint32_t seq;
+	int32_t pwrfail;
+	uint64_t samples;
+	uint64_t realtime_ns;
+	uint32_t period_us;
+	uint32_t num_values;
+	struct bbapi_ivshmem_value values[BBAPI_IVSHMEM_MAX_VALUES];
+};
+
+/**
+ * struct bbapi_ivshmem - the shared memory region
+ * @magic: BBAPI_IVSHMEM_MAGIC, written last when the region is set up
+ * @version: BBAPI_IVSHMEM_VERSION
+ * @size: size of this structure
+ * @pid: host pid of bbapi_ivshmem, 0 after it stopped
+ * @snapshot: the current values
+ */
+struct bbapi_ivshmem {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t size;
+	int32_t pid;
+	struct bbapi_ivshmem_snapshot snapshot;
+};
+
+/**
+ * bbapi_ivshmem_map_file() - map and validate a shared memory file
+ * @path: BBAPI_IVSHMEM_FILE on the host or resource2 of the PCI device
+ *
+ * Return: mapping or NULL with errno set
+ */
+static inline const struct bbapi_ivshmem *
+bbapi_ivshmem_map_file(const char *path)
+{
+	const int fd = open(path, O_RDONLY | O_CLOEXEC);
+	const struct bbapi_ivshmem *shm;
+	struct stat st;
+	void *map;
+
+	if (-1 == fd) {
+		return NULL;
+	}
+	if (fstat(fd, &st) || st.st_size < BBAPI_IVSHMEM_SIZE) {
+		close(fd);
+		errno = ENODATA;
+		return NULL;
+	}
+	map = mmap(NULL, BBAPI_IVSHMEM_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (MAP_FAILED == map) {
+		return NULL;
+	}
+	shm = (const struct bbapi_ivshmem *)map;
+	if (BBAPI_IVSHMEM_MAGIC !=
+	    __atomic_load_n(&shm->magic, __ATOMIC_ACQUIRE)
+	    || BBAPI_IVSHMEM_VERSION != shm->version
+	    || sizeof(struct bbapi_ivshmem) != shm->size) {
+		munmap(map, BBAPI_IVSHMEM_SIZE);
+		errno = ENODATA;
+		return NULL;
+	}
+	return shm;
+}
+
+static inline unsigned long bbapi_ivshmem_sysfs_id(const char *path)
+{
+	char buf[16] = { 0 };
+	const int fd = open(path, O_RDONLY | O_CLOEXEC);
+
+	if (-1 == fd) {
+		return 0;
+	}
+	if (read(fd, buf, sizeof(buf) - 1) < 0) {
+		buf[0] = 0;
+	}
+	close(fd);
+	return strtoul(buf, NULL, 0);
+}
+
+/**
+ * bbapi_ivshmem_map() - map the shared memory of bbapi_ivshmem
+ * @path: file to map or NULL to search all ivshmem PCI devices
+ *
+ * Mapping a PCI BAR through sysfs requires root in the guest. With
+ * several ivshmem devices the first one with a valid layout is used.
+ *
+ * Return: mapping or NULL with errno set
+ */
+static inline const struct bbapi_ivshmem *bbapi_ivshmem_map(const char *path)
+{
+	static const char pci[] = "/sys/bus/pci/devices/";
+	const struct bbapi_ivshmem *shm = NULL;
+	bool found = false;
+	struct dirent *entry;
+	DIR *dir;
+
+	if (path) {
+		return bbapi_ivshmem_map_file(path);
+	}
+
+	dir = opendir(pci);
+	if (!dir) {
+		return NULL;
+	}
+	while (!shm && (entry = readdir(dir))) {
+		char file[sizeof(pci) + 256 + 16];
+
+		snprintf(file, sizeof(file), "%s%s/vendor", pci, entry->d_name);
+		if (BBAPI_IVSHMEM_PCI_VENDOR != bbapi_ivshmem_sysfs_id(file)) {
+			continue;
+		}
+		snprintf(file, sizeof(file), "%s%s/device", pci, entry->d_name);
+		if (BBAPI_IVSHMEM_PCI_DEVICE != bbapi_ivshmem_sysfs_id(file)) {
+			continue;
+		}
+		snprintf(file, sizeof(file), "%s%s/resource2", pci,
+			 entry->d_name);
+		shm = bbapi_ivshmem_map_file(file);
+		found = true;
+	}
+	closedir(dir);
+	if (!found) {
+		errno = ENODEV;
+	}
+	return shm;
+}
+
+/**
+ * bbapi_ivshmem_read() - copy a consistent snapshot
+ *
+ * Return: 0 on success, -1 with errno EAGAIN if the host kept updating
+ * the snapshot for BBAPI_IVSHMEM_RETRIES attempts
+ */
+static inline int bbapi_ivshmem_read(const struct bbapi_ivshmem *shm,
+				     struct bbapi_ivshmem_snapshot *snap)
+{
+	for (int i = 0; i < BBAPI_IVSHMEM_RETRIES; ++i) {
+		const uint32_t seq =
+		    __atomic_load_n(&shm->snapshot.seq, __ATOMIC_ACQUIRE);
+		memcpy(snap, (const void *)&shm->snapshot, sizeof(*snap));
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (!(seq & 1)
+		    && seq == __atomic_load_n(&shm->snapshot.seq,
+					      __ATOMIC_RELAXED)) {
+			if (snap->num_values > BBAPI_IVSHMEM_MAX_VALUES) {
+				snap->num_values = BBAPI_IVSHMEM_MAX_VALUES;
+			}
+			return 0;
+		}
+	}
+	errno = EAGAIN;
+	return -1;
+}
+
+/**
+ * bbapi_ivshmem_find() - lookup a value of a snapshot by name
+ *
+ * Return: the value or NULL if the host doesn't publish it
+ */
+static inline const struct bbapi_ivshmem_value *
+bbapi_ivshmem_find(const struct bbapi_ivshmem_snapshot *snap, const char *name)
+{
+	for (uint32_t i = 0; i < snap->num_values; ++i) {
+		if (!strncmp(name, snap->values[i].name,
+			     BBAPI_IVSHMEM_MAX_NAME)) {
+			return &snap->values[i];
+		}
+	}
+	return NULL;
+}
+
+#endif /* #ifndef _BBAPI_IVSHMEM_H_ */
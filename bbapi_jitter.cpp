@@ -0,0 +1,444 @@
+// SPDX-License-Identifier: MIT
+/**
+    Measure the impact of BBAPI activity on realtime wakeup latency
+
+    usage: bbapi_jitter [options] -m <cpus> [-l <load>[,<load>...]]...
+
+    Like cyclictest, one SCHED_FIFO thread per measurement CPU sleeps on an
+    absolute CLOCK_MONOTONIC timer and records the difference between the
+    programmed and the actual wakeup time into a histogram with 1us buckets.
+
+    Every -l option defines one scenario, which is a set of load generators
+    running while the measurement threads are active. A scenario without
+    load ("idle") is always measured first as reference. A load is given as
+    <type>@<cpu>[:<Hz>] with <type> one of:
+      sensor    read all SENSORINFOs and CXPWRSUPP values from /dev/bbapi
+      display   write a full screen to /dev/cx_display
+      watchdog  ping /dev/watchdog (armed with 60s, disarmed at the end)
+    Without <Hz> the load runs as fast as possible.
+
+    example: compare BIOS access on an isolated and a shared core
+      bbapi_jitter -m 3 -l sensor@1 -l sensor@3 -o hist.dat
+
+    Copyright (C) 2026 Beckhoff Automation GmbH & Co. KG
+*/
+
+#include "bbapi_client.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <pthread.h>
+#include <sched.h>
+#include <string>
+#include <sys/mman.h>
+#include <thread>
+#include <vector>
+#ifndef __FreeBSD__
+#include <linux/watchdog.h>
+#endif /* #ifndef __FreeBSD__ */
+
+struct load {
+	std::string type;
+	int cpu;
+	double rate;
+};
+
+struct scenario {
+	std::string name;
+	std::vector < struct load >loads;
+	std::vector < uint64_t > histogram;
+	uint64_t overflows;
+	uint64_t count;
+	uint64_t min_ns;
+	uint64_t max_ns;
+	double sum_ns;
+	uint64_t load_ops;
+};
+
+struct jitter_config {
+	std::vector < int >cpus;
+	int priority;
+	uint64_t interval_ns;
+	double seconds;
+	size_t histogram_us;
+};
+
+static std::atomic < bool > g_stop;
+
+static bool pin_thread(int cpu)
+{
+#ifdef CPU_SET
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	return !pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+	return false;
+#endif
+}
+
+/**
+ * parse_cpu() - parse the number of a CPU this process may run on
+ * @end: receives the first character behind the number
+ *
+ * Return: the CPU or -1 if @text starts with no number or an offline CPU
+ */
+static int parse_cpu(const char *text, char **end)
+{
+	const long cpu = strtol(text, end, 0);
+
+	if (*end == text || cpu < 0) {
+		return -1;
+	}
+#ifdef CPU_SET
+	cpu_set_t set;
+	if (cpu >= CPU_SETSIZE || sched_getaffinity(0, sizeof(set), &set)
+	    || !CPU_ISSET(cpu, &set)) {
+		return -1;
+	}
+#endif
+	return cpu;
+}
+
+static void measure(const struct jitter_config *cfg, int cpu,
+		    struct scenario *s, std::atomic < int >*lock)
+{
+	std::vector < uint64_t > histogram(cfg->histogram_us, 0);
+	struct sched_param param;
+	uint64_t overflows = 0;
+	uint64_t count = 0;
+	uint64_t min_ns = UINT64_MAX;
+	uint64_t max_ns = 0;
+	double sum_ns = 0;
+
+	if (!pin_thread(cpu)) {
+		fprintf(stderr, "pin measurement thread to CPU%d failed\n", cpu);
+	}
+	param.sched_priority = cfg->priority;
+	if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param)) {
+		fprintf(stderr, "SCHED_FIFO failed, results are meaningless\n");
+	}
+
+	uint64_t next = bbapi_clock_ns() + cfg->interval_ns;
+	while (!g_stop) {
+		struct timespec ts = {
+			(time_t)(next / 1000000000ULL),
+			(long)(next % 1000000000ULL)
+		};
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+		const uint64_t now = bbapi_clock_ns();
+		const uint64_t latency = now > next ? now - next : 0;
+		const size_t bucket = latency / 1000;
+
+		if (bucket < histogram.size()) {
+			++histogram[bucket];
+		} else {
+			++overflows;
+		}
+		++count;
+		sum_ns += latency;
+		min_ns = std::min(min_ns, latency);
+		max_ns = std::max(max_ns, latency);
+
+		next += cfg->interval_ns;
+		while (next < now) {
+			next += cfg->interval_ns;
+		}
+	}
+
+	/* merge into the scenario results */
+	while (lock->exchange(1)) {
+	}
+	for (size_t i = 0; i < histogram.size(); ++i) {
+		s->histogram[i] += histogram[i];
+	}
+	s->overflows += overflows;
+	s->count += count;
+	s->sum_ns += sum_ns;
+	s->min_ns = std::min(s->min_ns, min_ns);
+	s->max_ns = std::max(s->max_ns, max_ns);
+	lock->store(0);
+}
+
+static uint64_t load_sensor(int fd)
+{
+	uint32_t num_sensors = 0;
+	uint64_t ops = 1;
+	int64_t value;
+
+	bbapi_ioctl_read(fd, BIOSIGRP_SYSTEM, BIOSIOFFS_SYSTEM_COUNT_SENSORS,
+			 &num_sensors, sizeof(num_sensors));
+	for (uint32_t i = BIOSIOFFS_SYSTEM_SENSOR_MIN; i <= num_sensors; ++i) {
+		SENSORINFO info;
+		bbapi_ioctl_read(fd, BIOSIGRP_SYSTEM, i, &info, sizeof(info));
+		++ops;
+	}
+	for (size_t i = 0; i < BBAPI_NUM_VALUES; ++i) {
+		if (BIOSIGRP_CXPWRSUPP == BBAPI_VALUES[i].group) {
+			bbapi_read_value(fd, &BBAPI_VALUES[i], &value);
+			++ops;
+		}
+	}
+	return ops;
+}
+
+static void generate_load(const struct load *l, std::atomic < uint64_t > *ops)
+{
+	static const char screen[] = "\fbbapi_jitter\nload generator";
+	const bool is_display = "display" == l->type;
+	const bool is_watchdog = "watchdog" == l->type;
+	const char *const path = is_display ? "/dev/cx_display"
+	    : is_watchdog ? "/dev/watchdog" : BBAPI_DEVICE;
+	const int fd = open(path, is_display || is_watchdog ? O_WRONLY : O_RDWR);
+	uint64_t local = 0;
+
+	if (-1 == fd) {
+		fprintf(stderr, "load '%s' open '%s' failed\n", l->type.c_str(),
+			path);
+		return;
+	}
+	if (!pin_thread(l->cpu)) {
+		fprintf(stderr, "pin load thread to CPU%d failed\n", l->cpu);
+	}
+#ifdef WDIOC_SETTIMEOUT
+	if (is_watchdog) {
+		int timeout = 60;
+		ioctl(fd, WDIOC_SETTIMEOUT, &timeout);
+	}
+#endif
+
+	const uint64_t period = l->rate > 0 ? 1e9 / l->rate : 0;
+	uint64_t next = bbapi_clock_ns();
+	while (!g_stop) {
+		if (is_display) {
+			local += sizeof(screen) - 1 == write(fd, screen,
+							     sizeof(screen) - 1);
+		} else if (is_watchdog) {
+#ifdef WDIOC_KEEPALIVE
+			local += !ioctl(fd, WDIOC_KEEPALIVE, 0);
+#endif
+		} else {
+			local += load_sensor(fd);
+		}
+
+		if (period) {
+			next += period;
+			struct timespec ts = {
+				(time_t)(next / 1000000000ULL),
+				(long)(next % 1000000000ULL)
+			};
+			clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+		}
+	}
+
+	if (is_watchdog && 1 != write(fd, "V", 1)) {
+		perror("watchdog magic close");
+	}
+	close(fd);
+	*ops += local;
+}
+
+static void run_scenario(const struct jitter_config *cfg, struct scenario *s)
+{
+	std::vector < std::thread > threads;
+	std::atomic < uint64_t > ops(0);
+	std::atomic < int >lock(0);
+
+	s->histogram.assign(cfg->histogram_us, 0);
+	s->overflows = 0;
+	s->count = 0;
+	s->min_ns = UINT64_MAX;
+	s->max_ns = 0;
+	s->sum_ns = 0;
+
+	g_stop = false;
+	for (size_t i = 0; i < s->loads.size(); ++i) {
+		threads.push_back(std::thread(generate_load, &s->loads[i], &ops));
+	}
+	for (size_t i = 0; i < cfg->cpus.size(); ++i) {
+		threads.push_back(std::thread(measure, cfg, cfg->cpus[i], s,
+					      &lock));
+	}
+
+	std::this_thread::sleep_for(std::chrono::duration < double >
+				    (cfg->seconds));
+	g_stop = true;
+	for (auto & t:threads) {
+		t.join();
+	}
+	s->load_ops = ops;
+}
+
+static uint64_t percentile_us(const struct scenario *s, double p)
+{
+	const uint64_t target = p * s->count;
+	uint64_t sum = 0;
+
+	for (size_t i = 0; i < s->histogram.size(); ++i) {
+		sum += s->histogram[i];
+		if (sum >= target) {
+			return i;
+		}
+	}
+	return s->histogram.size();
+}
+
+static bool parse_scenario(const char *spec, struct scenario *s)
+{
+	std::string text(spec);
+	size_t pos = 0;
+
+	s->name = text;
+	while (pos < text.size()) {
+		const size_t end = std::min(text.find(',', pos), text.size());
+		const std::string item = text.substr(pos, end - pos);
+		const size_t at = item.find('@');
+		struct load l;
+		char *p;
+
+		if (std::string::npos == at) {
+			return false;
+		}
+		l.type = item.substr(0, at);
+		l.cpu = parse_cpu(item.c_str() + at + 1, &p);
+		if (l.cpu < 0 || (*p && ':' != *p)) {
+			return false;
+		}
+		l.rate = 0;
+		if (':' == *p) {
+			const char *const rate = p + 1;
+			l.rate = strtod(rate, &p);
+			if (p == rate || *p || l.rate < 0) {
+				return false;
+			}
+		}
+		if ("sensor" != l.type && "display" != l.type
+		    && "watchdog" != l.type) {
+			return false;
+		}
+		s->loads.push_back(l);
+		pos = end + 1;
+	}
+	return !s->loads.empty();
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+		"usage: %s [options] -m <cpu>[,<cpu>...] [-l <load>[,<load>...]]...\n\n"
+		" -m  CPUs to run the measurement threads on\n"
+		" -l  scenario: list of <type>@<cpu>[:<Hz>], type: sensor|display|watchdog\n"
+		" -p  SCHED_FIFO priority of the measurement threads (default: 80)\n"
+		" -i  measurement interval in us (default: 1000)\n"
+		" -d  duration of each scenario in seconds (default: 10)\n"
+		" -b  histogram size in us (default: 1000)\n"
+		" -o  write histograms to file (one column per scenario)\n",
+		name);
+}
+
+int main(int argc, char *argv[])
+{
+	struct jitter_config cfg;
+	std::vector < struct scenario >scenarios(1);
+	const char *output = NULL;
+	int opt;
+
+	cfg.priority = 80;
+	cfg.interval_ns = 1000000;
+	cfg.seconds = 10;
+	cfg.histogram_us = 1000;
+	scenarios[0].name = "idle";
+
+	while ((opt = getopt(argc, argv, "m:l:p:i:d:b:o:h")) != -1) {
+		switch (opt) {
+		case 'm':
+			for (char *p = optarg; *p;) {
+				char *end;
+				const int cpu = parse_cpu(p, &end);
+				if (cpu < 0 || (*end && ',' != *end)) {
+					fprintf(stderr, "invalid cpus '%s'\n",
+						optarg);
+					return -1;
+				}
+				cfg.cpus.push_back(cpu);
+				p = end + (',' == *end);
+			}
+			break;
+		case 'l':
+			scenarios.push_back(scenario());
+			if (!parse_scenario(optarg, &scenarios.back())) {
+				fprintf(stderr, "invalid load '%s'\n", optarg);
+				return -1;
+			}
+			break;
+		case 'p':
+			cfg.priority = atoi(optarg);
+			break;
+		case 'i':
+			cfg.interval_ns = strtoull(optarg, NULL, 0) * 1000;
+			break;
+		case 'd':
+			cfg.seconds = atof(optarg);
+			break;
+		case 'b':
+			cfg.histogram_us = strtoul(optarg, NULL, 0);
+			break;
+		case 'o':
+			output = optarg;
+			break;
+		default:
+			usage(argv[0]);
+			return -1;
+		}
+	}
+
+	if (cfg.cpus.empty() || !cfg.interval_ns || !cfg.histogram_us
+	    || cfg.seconds <= 0) {
+		usage(argv[0]);
+		return -1;
+	}
+
+	if (mlockall(MCL_CURRENT | MCL_FUTURE)) {
+		perror("mlockall");
+	}
+
+	printf("%-32s %10s %8s %8s %8s %8s %8s %10s %12s\n", "scenario",
+	       "samples", "min", "avg", "p99", "p99.99", "max", "overflows",
+	       "load ops/s");
+	for (size_t i = 0; i < scenarios.size(); ++i) {
+		struct scenario &s = scenarios[i];
+		run_scenario(&cfg, &s);
+		printf("%-32s %10llu %8llu %8.0f %8llu %8llu %8llu %10llu %12.0f\n",
+		       s.name.c_str(), (unsigned long long)s.count,
+		       (unsigned long long)(s.count ? s.min_ns / 1000 : 0),
+		       s.count ? s.sum_ns / s.count / 1000 : 0,
+		       (unsigned long long)percentile_us(&s, 0.99),
+		       (unsigned long long)percentile_us(&s, 0.9999),
+		       (unsigned long long)(s.max_ns / 1000),
+		       (unsigned long long)s.overflows, s.load_ops / cfg.seconds);
+	}
+	printf("all latencies in us\n");
+
+	if (output) {
+		FILE *const f = fopen(output, "w");
+		if (!f) {
+			perror(output);
+			return -1;
+		}
+		fprintf(f, "# us");
+		for (size_t i = 0; i < scenarios.size(); ++i) {
+			fprintf(f, " %s", scenarios[i].name.c_str());
+		}
+		fprintf(f, "\n");
+		for (size_t us = 0; us < cfg.histogram_us; ++us) {
+			fprintf(f, "%06zu", us);
+			for (size_t i = 0; i < scenarios.size(); ++i) {
+				fprintf(f, " %llu", (unsigned long long)
+					scenarios[i].histogram[us]);
+			}
+			fprintf(f, "\n");
+		}
+		fclose(f);
+	}
+	return 0;
+}
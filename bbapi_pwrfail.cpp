@@ -0,0 +1,392 @@
+// SPDX-License-Identifier: MIT
+/**
+    Low latency power fail monitor for the S-UPS 'sups_pwrfail' GPIO
+
+    usage: bbapi_pwrfail [options] [-k <pid>[:<signal>]]... [-x <command>]...
+
+    The GPIO provided by bbapi_sups is accessed through the GPIO character
+    device, the line is looked up by its name. If the GPIO chip supports
+    edge events the monitor sleeps until the kernel reports a rising edge.
+    Otherwise, and with -P, the line value is polled with a fixed period
+    from a SCHED_FIFO thread. With -S the deprecated sysfs value file is
+    polled instead, for kernels without GPIO character device.
+
+    All memory is locked with mlockall() before the monitor is armed. On
+    power fail the registered actions run in the order of the command line:
+      -k <pid>[:<signal>]  send a signal (default: PWR) to a process
+      -x <command>         spawn "/bin/sh -c <command>" without waiting
+    Commands run with SCHED_OTHER, a busy shutdown script shall not starve
+    the system at the SCHED_FIFO priority of the monitor. After all actions
+    the latency from detection to the completion of each action is logged.
+    In event mode the detection timestamp is taken from the kernel event,
+    in poll mode it is the time of the first sample reading the power fail,
+    which is at most one period behind the edge.
+
+    Copyright (C) 2026 Beckhoff Automation GmbH & Co. KG
+*/
+
+#include "bbapi_client.h"
+#include <poll.h>
+#include <sched.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <linux/gpio.h>
+#include <sys/mman.h>
+
+#define CONSUMER "bbapi_pwrfail"
+#define DEFAULT_INTERVAL_US 1000
+#define DEFAULT_PRIORITY 80
+
+extern char **environ;
+
+enum mode {
+	MODE_EVENT,
+	MODE_POLL,
+	MODE_SYSFS,
+};
+
+static const char *const MODE_NAMES[] = {
+	"gpio edge event", "gpio poll", "sysfs poll",
+};
+
+/**
+ * struct action - something to do on power fail
+ * @pid: target of the signal, 0 for a command
+ * @sig: signal sent to @pid
+ * @cmd: shell command to spawn if @pid is 0
+ * @done_ns: CLOCK_MONOTONIC when the action was completed
+ * @result: 0 on success, errno otherwise
+ */
+struct action {
+	pid_t pid;
+	int sig;
+	const char *cmd;
+	uint64_t done_ns;
+	int result;
+};
+
+static const struct {
+	const char *name;
+	int sig;
+} SIGNALS[] = {
+	{"PWR", SIGPWR}, {"TERM", SIGTERM}, {"INT", SIGINT}, {"HUP", SIGHUP},
+	{"USR1", SIGUSR1}, {"USR2", SIGUSR2}, {"KILL", SIGKILL},
+};
+
+static volatile sig_atomic_t g_stop;
+
+static void on_signal(int sig)
+{
+	g_stop = 1;
+}
+
+static bool parse_kill(const char *arg, struct action *a)
+{
+	char *end;
+
+	a->pid = strtol(arg, &end, 0);
+	a->sig = SIGPWR;
+	a->cmd = NULL;
+	if (a->pid <= 0 || (*end && ':' != *end)) {
+		return false;
+	}
+	if (!*end) {
+		return true;
+	}
+
+	const char *name = end + 1;
+	if (!strncmp(name, "SIG", 3)) {
+		name += 3;
+	}
+	for (size_t i = 0; i < sizeof(SIGNALS) / sizeof(SIGNALS[0]); ++i) {
+		if (!strcmp(name, SIGNALS[i].name)) {
+			a->sig = SIGNALS[i].sig;
+			return true;
+		}
+	}
+	a->sig = strtol(name, &end, 0);
+	return !*end && a->sig > 0 && a->sig < NSIG;
+}
+
+/**
+ * read_line() - sample the current line value
+ *
+ * Return: 1 on power fail, 0 on power good and -1 on error
+ */
+static int read_line(enum mode mode, int fd)
+{
+	if (MODE_SYSFS == mode) {
+		char value;
+		if (1 != pread(fd, &value, 1, 0)) {
+			return -1;
+		}
+		return '0' != value;
+	}
+	return bbapi_gpio_read_line(fd);
+}
+
+/**
+ * drain_events() - discard all queued edge events of a line
+ */
+static void drain_events(int fd)
+{
+	struct pollfd pfd = { fd, POLLIN, 0 };
+	struct gpioevent_data event;
+
+	while (poll(&pfd, 1, 0) > 0
+	       && (ssize_t)sizeof(event) == read(fd, &event, sizeof(event))) {
+	}
+}
+
+static void run_actions(std::vector < struct action >&actions)
+{
+	for (size_t i = 0; i < actions.size(); ++i) {
+		struct action &a = actions[i];
+		if (a.pid) {
+			a.result = kill(a.pid, a.sig) ? errno : 0;
+		} else {
+			const char *const argv[] = { "sh", "-c", a.cmd, NULL };
+			struct sched_param param;
+			posix_spawnattr_t attr;
+			sigset_t def;
+			pid_t pid;
+
+			/* the child shall not inherit our SIGCHLD auto reaping */
+			sigemptyset(&def);
+			sigaddset(&def, SIGCHLD);
+			/* nor our realtime priority */
+			param.sched_priority = 0;
+			posix_spawnattr_init(&attr);
+			posix_spawnattr_setsigdefault(&attr, &def);
+			posix_spawnattr_setschedpolicy(&attr, SCHED_OTHER);
+			posix_spawnattr_setschedparam(&attr, &param);
+			posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGDEF
+						 | POSIX_SPAWN_SETSCHEDULER);
+			a.result = posix_spawn(&pid, "/bin/sh", NULL, &attr,
+					       (char *const *)argv, environ);
+			posix_spawnattr_destroy(&attr);
+		}
+		a.done_ns = bbapi_clock_ns();
+	}
+}
+
+static void log_actions(const std::vector < struct action >&actions,
+			uint64_t detected_ns, uint64_t woken_ns)
+{
+	printf("power fail detected, woken after %llu us\n",
+	       (unsigned long long)(woken_ns - detected_ns) / 1000);
+	for (size_t i = 0; i < actions.size(); ++i) {
+		const struct action &a = actions[i];
+		const unsigned long long us =
+		    (a.done_ns - detected_ns) / 1000;
+		if (a.pid) {
+			printf("  %8llu us: kill(%d, %d) %s\n", us, a.pid,
+			       a.sig, a.result ? strerror(a.result) : "done");
+		} else {
+			printf("  %8llu us: '%s' %s\n", us, a.cmd,
+			       a.result ? strerror(a.result) : "spawned");
+		}
+	}
+	fflush(stdout);
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+		"usage: %s [options] [-k <pid>[:<signal>]]... [-x <command>]...\n\n"
+		" -k  send <signal> (default: PWR) to <pid> on power fail\n"
+		" -x  spawn '/bin/sh -c <command>' on power fail\n"
+		" -c  GPIO chip (default: lookup line '%s')\n"
+		" -l  line offset on the GPIO chip given with -c (default: 0)\n"
+		" -S  poll this sysfs value file instead of the GPIO chip\n"
+		" -P  poll even if the GPIO chip supports edge events\n"
+		" -i  poll interval in us (default: %d)\n"
+		" -p  SCHED_FIFO priority (default: %d)\n"
+		" -1  exit after the first power fail\n",
+		name, BBAPI_PWRFAIL_LINE, DEFAULT_INTERVAL_US, DEFAULT_PRIORITY);
+}
+
+int main(int argc, char *argv[])
+{
+	std::vector < struct action >actions;
+	std::string chip;
+	uint32_t offset = 0;
+	const char *sysfs = NULL;
+	bool force_poll = false;
+	bool oneshot = false;
+	long interval_us = DEFAULT_INTERVAL_US;
+	int priority = DEFAULT_PRIORITY;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "k:x:c:l:S:Pi:p:1h")) != -1) {
+		struct action a;
+		switch (opt) {
+		case 'k':
+			if (!parse_kill(optarg, &a)) {
+				fprintf(stderr, "invalid action '%s'\n", optarg);
+				return -1;
+			}
+			actions.push_back(a);
+			break;
+		case 'x':
+			a.pid = 0;
+			a.sig = 0;
+			a.cmd = optarg;
+			actions.push_back(a);
+			break;
+		case 'c':
+			chip = optarg;
+			break;
+		case 'l':
+			offset = strtoul(optarg, NULL, 0);
+			break;
+		case 'S':
+			sysfs = optarg;
+			break;
+		case 'P':
+			force_poll = true;
+			break;
+		case 'i':
+			interval_us = atol(optarg);
+			break;
+		case 'p':
+			priority = atoi(optarg);
+			break;
+		case '1':
+			oneshot = true;
+			break;
+		default:
+			usage(argv[0]);
+			return -1;
+		}
+	}
+
+	if (optind != argc || interval_us <= 0) {
+		usage(argv[0]);
+		return -1;
+	}
+
+	enum mode mode = MODE_EVENT;
+	int fd = -1;
+	if (sysfs) {
+		mode = MODE_SYSFS;
+		fd = open(sysfs, O_RDONLY | O_CLOEXEC);
+		if (-1 == fd) {
+			perror(sysfs);
+			return -1;
+		}
+	} else {
+		if (chip.empty()
+		    && !bbapi_gpio_find_line(BBAPI_PWRFAIL_LINE, &chip,
+					     &offset)) {
+			fprintf(stderr, "GPIO line '%s' not found, "
+				"is bbapi_sups loaded?\n", BBAPI_PWRFAIL_LINE);
+			return -1;
+		}
+		if (!force_poll) {
+			fd = bbapi_gpio_request_line(chip.c_str(), offset,
+						     CONSUMER,
+						     GPIOEVENT_REQUEST_BOTH_EDGES);
+		}
+		if (-1 == fd) {
+			mode = MODE_POLL;
+			fd = bbapi_gpio_request_line(chip.c_str(), offset,
+						     CONSUMER, 0);
+		}
+		if (-1 == fd) {
+			fprintf(stderr, "request %s line %u failed: %s\n",
+				chip.c_str(), offset, strerror(errno));
+			return -1;
+		}
+	}
+
+	signal(SIGINT, on_signal);
+	signal(SIGTERM, on_signal);
+	signal(SIGCHLD, SIG_IGN);
+
+	if (mlockall(MCL_CURRENT | MCL_FUTURE)) {
+		perror("mlockall");
+	}
+
+	struct sched_param param;
+	param.sched_priority = priority;
+	if (sched_setscheduler(0, SCHED_FIFO, &param)) {
+		perror("SCHED_FIFO");
+	}
+
+	printf("monitoring %s in %s mode with %zu actions\n",
+	       sysfs ? sysfs : chip.c_str(), MODE_NAMES[mode], actions.size());
+	fflush(stdout);
+
+	bool failed = false;
+	bool sampled = false;
+	struct timespec next;
+	clock_gettime(CLOCK_MONOTONIC, &next);
+
+	while (!g_stop) {
+		uint64_t detected_ns = 0;
+		int value;
+
+		if (MODE_EVENT == mode && !sampled) {
+			/*
+			 * The initial state is not reported as event. Edges
+			 * queued before the sample are part of it, afterwards
+			 * the state is only taken from events.
+			 */
+			drain_events(fd);
+			value = read_line(mode, fd);
+			detected_ns = bbapi_clock_ns();
+			sampled = true;
+		} else if (MODE_EVENT == mode) {
+			struct pollfd pfd = { fd, POLLIN, 0 };
+			struct gpioevent_data event;
+			if (poll(&pfd, 1, -1) <= 0) {
+				continue;
+			}
+			if ((ssize_t)sizeof(event) != read(fd, &event,
+							   sizeof(event))) {
+				perror("read event");
+				break;
+			}
+			value = GPIOEVENT_EVENT_RISING_EDGE == event.id;
+			detected_ns = bbapi_gpio_event_ns(event.timestamp);
+		} else {
+			next.tv_nsec += interval_us * 1000;
+			while (next.tv_nsec >= 1000000000) {
+				next.tv_nsec -= 1000000000;
+				next.tv_sec++;
+			}
+			clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next,
+					NULL);
+			value = read_line(mode, fd);
+			detected_ns = bbapi_clock_ns();
+		}
+
+		if (-1 == value) {
+			perror("read line");
+			break;
+		}
+
+		if (value && !failed) {
+			const uint64_t woken_ns = bbapi_clock_ns();
+			run_actions(actions);
+			log_actions(actions, detected_ns, woken_ns);
+			failed = true;
+			if (oneshot) {
+				break;
+			}
+		} else if (!value && failed) {
+			printf("power restored\n");
+			fflush(stdout);
+			failed = false;
+		}
+	}
+
+	close(fd);
+	return 0;
+}
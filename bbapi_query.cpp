@@ -0,0 +1,254 @@
+// SPDX-License-Identifier: MIT
+/**
+    Extract time ranges and aggregates from a bbapi_recorder file
+
+    usage: bbapi_query [-f <from>] [-t <to>] [-b <sec>] [-c <value>]... <file>
+
+    Without -b all samples in [from, to] are printed as CSV. With -b the
+    samples are grouped into buckets of <sec> seconds and min/max/mean and
+    the number of valid samples are printed per bucket and column.
+    <from> and <to> are seconds since the epoch. Only chunks overlapping
+    the requested range are read and decoded, they are located with a
+    binary search on the chunk index.
+
+    Copyright (C) 2026 Beckhoff Automation GmbH & Co. KG
+*/
+
+#include "bbapi_recorder.h"
+#include <algorithm>
+#include <limits>
+
+struct aggregate {
+	int64_t min;
+	int64_t max;
+	double sum;
+	uint64_t count;
+
+	void reset() {
+		min = std::numeric_limits < int64_t >::max();
+		max = std::numeric_limits < int64_t >::min();
+		sum = 0;
+		count = 0;
+	}
+
+	void add(int64_t value) {
+		min = std::min(min, value);
+		max = std::max(max, value);
+		sum += value;
+		++count;
+	}
+};
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+		"usage: %s [-f <from>] [-t <to>] [-b <sec>] [-c <value>]... <file>\n\n"
+		" -f  first timestamp in seconds since the epoch (default: first sample)\n"
+		" -t  last timestamp in seconds since the epoch (default: last sample)\n"
+		" -b  print min/max/mean per bucket of <sec> seconds\n"
+		" -c  print only this column, can be used multiple times\n",
+		name);
+}
+
+static void print_time(int64_t us)
+{
+	printf("%lld.%06lld", (long long)(us / 1000000),
+	       (long long)(us % 1000000));
+}
+
+/**
+ * print_buckets() - print and reset the aggregates of one time bucket
+ * @aggr: one aggregate per output column, a column may be selected twice
+ */
+static void print_buckets(int64_t start, std::vector < struct aggregate >&aggr)
+{
+	print_time(start);
+	for (size_t i = 0; i < aggr.size(); ++i) {
+		struct aggregate &a = aggr[i];
+		if (a.count) {
+			printf(",%lld,%lld,%.3f,%llu", (long long)a.min,
+			       (long long)a.max, a.sum / a.count,
+			       (unsigned long long)a.count);
+		} else {
+			printf(",,,,0");
+		}
+		a.reset();
+	}
+	printf("\n");
+}
+
+int main(int argc, char *argv[])
+{
+	std::vector < struct column_desc >columns;
+	std::vector < struct index_entry >index;
+	std::vector < const char *>selected;
+	std::vector < size_t > cols;
+	std::vector < struct aggregate >aggr;
+	int64_t from = std::numeric_limits < int64_t >::min();
+	int64_t to = std::numeric_limits < int64_t >::max();
+	int64_t bucket = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "f:t:b:c:h")) != -1) {
+		switch (opt) {
+		case 'f':
+			from = atof(optarg) * 1000000;
+			break;
+		case 't':
+			to = atof(optarg) * 1000000;
+			break;
+		case 'b':
+			bucket = atof(optarg) * 1000000;
+			break;
+		case 'c':
+			selected.push_back(optarg);
+			break;
+		default:
+			usage(argv[0]);
+			return -1;
+		}
+	}
+
+	if (argc - optind != 1 || bucket < 0 || from > to) {
+		usage(argv[0]);
+		return -1;
+	}
+
+	const char *const path = argv[optind];
+	const int fd = open(path, O_RDONLY);
+	if (-1 == fd) {
+		perror(path);
+		return -1;
+	}
+
+	const off_t start = record_read_header(fd, columns);
+	if (-1 == start) {
+		fprintf(stderr, "'%s' is no valid record file\n", path);
+		return -1;
+	}
+
+	if (selected.empty()) {
+		for (size_t i = 0; i < columns.size(); ++i) {
+			cols.push_back(i);
+		}
+	}
+	for (size_t i = 0; i < selected.size(); ++i) {
+		size_t col = 0;
+		while (col < columns.size()
+		       && strncmp(selected[i], columns[col].name,
+				  sizeof(columns[col].name))) {
+			++col;
+		}
+		if (col == columns.size()) {
+			fprintf(stderr, "'%s' contains no '%s'\n", path,
+				selected[i]);
+			return -1;
+		}
+		cols.push_back(col);
+	}
+
+	const std::string idx_path = std::string(path) + RECORD_INDEX_SUFFIX;
+	const int idx_fd = open(idx_path.c_str(), O_RDONLY);
+	record_recover(fd, idx_fd, start, index);
+	if (-1 != idx_fd) {
+		close(idx_fd);
+	}
+
+	printf("time");
+	for (size_t i = 0; i < cols.size(); ++i) {
+		const char *const name = columns[cols[i]].name;
+		const int len = sizeof(columns[cols[i]].name);
+		if (bucket) {
+			printf(",%.*s_min,%.*s_max,%.*s_mean,%.*s_count",
+			       len, name, len, name, len, name, len, name);
+		} else {
+			printf(",%.*s", len, name);
+		}
+	}
+	printf("\n");
+
+	/*
+	 * Chunks are in recording order, which is not time order after a
+	 * clock step. The running maximum of max_us is sorted, all chunks
+	 * before the first one reaching 'from' end before 'from'. Likewise
+	 * all chunks behind a position, whose minimum of min_us of all
+	 * following chunks is beyond 'to', start after 'to'.
+	 */
+	std::vector < int64_t > max_before(index.size());
+	std::vector < int64_t > min_after(index.size());
+	for (size_t i = 0; i < index.size(); ++i) {
+		max_before[i] = i ? std::max(max_before[i - 1], index[i].max_us)
+		    : index[i].max_us;
+	}
+	for (size_t i = index.size(); i-- > 0;) {
+		min_after[i] = i + 1 < index.size() ?
+		    std::min(min_after[i + 1], index[i].min_us)
+		    : index[i].min_us;
+	}
+	size_t pos = std::lower_bound(max_before.begin(), max_before.end(),
+				      from) - max_before.begin();
+
+	struct chunk c;
+	struct chunk_header hdr;
+	std::string payload;
+	int64_t bucket_start = 0;
+	bool bucket_open = false;
+
+	aggr.resize(cols.size());
+	for (size_t i = 0; i < aggr.size(); ++i) {
+		aggr[i].reset();
+	}
+
+	for (; pos < index.size() && min_after[pos] <= to; ++pos) {
+		const struct index_entry *const it = &index[pos];
+		if (it->max_us < from || it->min_us > to) {
+			continue;
+		}
+		if (!record_read_chunk(fd, it->offset, &hdr, &payload)
+		    || !chunk_decode(&hdr, (const uint8_t *)payload.data(),
+				     columns.size(), &c)) {
+			fprintf(stderr, "skip damaged chunk at %llu\n",
+				(unsigned long long)it->offset);
+			continue;
+		}
+
+		for (size_t row = 0; row < c.time_us.size(); ++row) {
+			const int64_t t = c.time_us[row];
+			if (t < from || t > to) {
+				continue;
+			}
+
+			if (!bucket) {
+				print_time(t);
+				for (size_t i = 0; i < cols.size(); ++i) {
+					if (c.valid[cols[i]][row]) {
+						printf(",%lld", (long long)
+						       c.values[cols[i]][row]);
+					} else {
+						printf(",");
+					}
+				}
+				printf("\n");
+				continue;
+			}
+
+			const int64_t b = t - ((t % bucket) + bucket) % bucket;
+			if (bucket_open && b != bucket_start) {
+				print_buckets(bucket_start, aggr);
+			}
+			bucket_start = b;
+			bucket_open = true;
+			for (size_t i = 0; i < cols.size(); ++i) {
+				if (c.valid[cols[i]][row]) {
+					aggr[i].add(c.values[cols[i]][row]);
+				}
+			}
+		}
+	}
+
+	if (bucket_open) {
+		print_buckets(bucket_start, aggr);
+	}
+	close(fd);
+	return 0;
+}
@@ -0,0 +1,263 @@
+// SPDX-License-Identifier: MIT
+/**
+    Record BBAPI values into a compact columnar file
+
+    usage: bbapi_recorder [-r <Hz>] [-n <rows>] [-s <sec>] <file> <value>...
+
+    <value> is a name from BBAPI_VALUES in bbapi_client.h or
+    SYSTEM_SENSOR<n>, e.g.:
+      bbapi_recorder -r 10 /var/log/ups.bbr CXPWRSUPP_GET24VOLT CXUPS_GETPOWERSTATUS
+
+    Samples are buffered in memory and written as one chunk when either
+    <rows> samples are collected or <sec> seconds passed. An existing file
+    with the same columns is continued, a torn chunk at its end (e.g. due
+    to a power loss) is discarded. See bbapi_recorder.h for the file format.
+
+    Copyright (C) 2026 Beckhoff Automation GmbH & Co. KG
+*/
+
+#include "bbapi_recorder.h"
+#include <signal.h>
+
+static volatile sig_atomic_t g_stop;
+
+static void on_signal(int sig)
+{
+	g_stop = 1;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+		"usage: %s [-r <Hz>] [-n <rows>] [-s <sec>] <file> <value>...\n\n"
+		" -r  sample rate in Hz (default: 1)\n"
+		" -n  maximum number of rows per chunk (default: 4096)\n"
+		" -s  maximum number of seconds per chunk (default: 10)\n\n"
+		"<value> is SYSTEM_SENSOR<n> or one of:\n", name);
+	for (size_t i = 0; i < BBAPI_NUM_VALUES; ++i) {
+		fprintf(stderr, "  %s\n", BBAPI_VALUES[i].name);
+	}
+}
+
+/**
+ * open_record() - create a new or continue an existing record file
+ *
+ * Return: file descriptor of the record file positioned at the end of
+ * the valid data or -1 on error.
+ */
+static int open_record(const char *path,
+		       const std::vector < struct column_desc >&columns,
+		       int *idx_fd)
+{
+	const std::string idx_path = std::string(path) + RECORD_INDEX_SUFFIX;
+	const int fd = open(path, O_RDWR | O_CREAT, 0644);
+	std::vector < struct column_desc >existing;
+	std::vector < struct index_entry >index;
+	struct stat st;
+
+	if (-1 == fd || fstat(fd, &st)) {
+		perror(path);
+		return -1;
+	}
+
+	*idx_fd = open(idx_path.c_str(), O_RDWR | O_CREAT, 0644);
+	if (-1 == *idx_fd) {
+		perror(idx_path.c_str());
+		close(fd);
+		return -1;
+	}
+
+	if (!st.st_size) {
+		struct file_header hdr;
+		memcpy(hdr.magic, RECORD_MAGIC, sizeof(hdr.magic));
+		hdr.version = RECORD_VERSION;
+		hdr.num_columns = columns.size();
+		if (ftruncate(*idx_fd, 0)
+		    || !write_full(fd, &hdr, sizeof(hdr))
+		    || !write_full(fd, &columns[0],
+				   columns.size() * sizeof(columns[0]))
+		    || fsync(fd)) {
+			perror(path);
+			goto rollback;
+		}
+		return fd;
+	}
+
+	{
+		const off_t start = record_read_header(fd, existing);
+		if (-1 == start) {
+			fprintf(stderr, "'%s' is no valid record file\n", path);
+			goto rollback;
+		}
+
+		if (existing.size() != columns.size()
+		    || memcmp(&existing[0], &columns[0],
+			      columns.size() * sizeof(columns[0]))) {
+			fprintf(stderr,
+				"'%s' was recorded with other values\n", path);
+			goto rollback;
+		}
+
+		const off_t end = record_recover(fd, *idx_fd, start, index);
+		if (end != st.st_size) {
+			fprintf(stderr,
+				"discard %lld damaged bytes at the end of '%s'\n",
+				(long long)(st.st_size - end), path);
+		}
+		if (ftruncate(fd, end) || -1 == lseek(fd, end, SEEK_SET)) {
+			perror(path);
+			goto rollback;
+		}
+	}
+	return fd;
+
+rollback:
+	close(*idx_fd);
+	close(fd);
+	return -1;
+}
+
+static bool flush_chunk(int fd, int idx_fd, const struct chunk *c)
+{
+	struct chunk_header hdr;
+	struct index_entry e;
+	std::string buf;
+
+	if (c->time_us.empty()) {
+		return true;
+	}
+
+	const off_t off = lseek(fd, 0, SEEK_CUR);
+	chunk_encode(c, &hdr, buf);
+	buf.insert(0, (const char *)&hdr, sizeof(hdr));
+	if (-1 == off || !write_full(fd, buf.data(), buf.size())
+	    || fdatasync(fd)) {
+		perror("write chunk");
+		return false;
+	}
+
+	e.min_us = *std::min_element(c->time_us.begin(), c->time_us.end());
+	e.max_us = *std::max_element(c->time_us.begin(), c->time_us.end());
+	e.offset = off;
+	e.num_rows = hdr.num_rows;
+	e.crc = index_entry_crc(&e);
+	if (!write_full(idx_fd, &e, sizeof(e))) {
+		/* not fatal, the index is rebuild on next open */
+		perror("write index");
+	}
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	std::vector < struct bbapi_value >values;
+	std::vector < struct column_desc >columns;
+	double rate = 1;
+	size_t max_rows = 4096;
+	double max_sec = 10;
+	struct chunk c;
+	int opt;
+	int idx_fd;
+
+	while ((opt = getopt(argc, argv, "r:n:s:h")) != -1) {
+		switch (opt) {
+		case 'r':
+			rate = atof(optarg);
+			break;
+		case 'n':
+			max_rows = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			max_sec = atof(optarg);
+			break;
+		default:
+			usage(argv[0]);
+			return -1;
+		}
+	}
+
+	if (argc - optind < 2 || rate <= 0 || !max_rows || max_sec <= 0
+	    || argc - optind - 1 > RECORD_MAX_COLUMNS) {
+		usage(argv[0]);
+		return -1;
+	}
+
+	for (int i = optind + 1; i < argc; ++i) {
+		struct bbapi_value v;
+		struct column_desc col;
+		if (!bbapi_find_value(argv[i], &v)) {
+			fprintf(stderr, "unknown value '%s'\n", argv[i]);
+			return -1;
+		}
+		memset(&col, 0, sizeof(col));
+		strncpy(col.name, v.name, sizeof(col.name) - 1);
+		col.group = v.group;
+		col.offset = v.offset;
+		col.size = v.size;
+		col.is_signed = v.is_signed;
+		values.push_back(v);
+		columns.push_back(col);
+	}
+
+	const int bbapi_dev = open(BBAPI_DEVICE, O_RDWR);
+	if (-1 == bbapi_dev) {
+		printf("Open '%s' failed\n", BBAPI_DEVICE);
+		return -1;
+	}
+
+	const int fd = open_record(argv[optind], columns, &idx_fd);
+	if (-1 == fd) {
+		return -1;
+	}
+
+	signal(SIGINT, on_signal);
+	signal(SIGTERM, on_signal);
+
+	const uint64_t period_ns = 1000000000.0 / rate;
+	const uint64_t chunk_ns = max_sec * 1000000000.0;
+	uint64_t next = bbapi_clock_ns();
+	uint64_t chunk_start = next;
+	int result = 0;
+
+	c.reset(values.size());
+	while (!g_stop) {
+		c.time_us.push_back(bbapi_clock_ns(CLOCK_REALTIME) / 1000);
+		for (size_t i = 0; i < values.size(); ++i) {
+			int64_t value = 0;
+			const bool ok = !bbapi_read_value(bbapi_dev, &values[i],
+							  &value);
+			c.values[i].push_back(value);
+			c.valid[i].push_back(ok);
+		}
+
+		if (c.time_us.size() >= max_rows
+		    || bbapi_clock_ns() - chunk_start >= chunk_ns) {
+			if (!flush_chunk(fd, idx_fd, &c)) {
+				result = -1;
+				break;
+			}
+			c.reset(values.size());
+			chunk_start = bbapi_clock_ns();
+		}
+
+		next += period_ns;
+		const uint64_t now = bbapi_clock_ns();
+		if (next < now) {
+			/* we are late, skip missed samples instead of bursting */
+			next = now;
+		}
+		struct timespec ts = {
+			(time_t)(next / 1000000000ULL),
+			(long)(next % 1000000000ULL)
+		};
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+	}
+
+	if (!flush_chunk(fd, idx_fd, &c)) {
+		result = -1;
+	}
+	close(idx_fd);
+	close(fd);
+	close(bbapi_dev);
+	return result;
+}
@@ -0,0 +1,468 @@
+// SPDX-License-Identifier: MIT
+/**
+    Columnar file format used by bbapi_recorder and bbapi_query
+
+    A record file starts with a header describing the recorded columns
+    followed by an append-only sequence of chunks:
+
+    +-------------+--------------+------------------+-----+
+    | file_header | column_desc[]| chunk_header     | ... |
+    |             |              | chunk payload    |     |
+    +-------------+--------------+------------------+-----+
+
+    The chunk payload is encoded column by column:
+      - timestamps as zigzag varint deltas to the previous row
+        (the first row is relative to chunk_header.first_us)
+      - for each value column: varint number of missing rows, varint deltas
+        of the missing row indices and zigzag varint deltas of the values of
+        all remaining rows.
+
+    Each chunk is protected by a CRC32 and written with a single write()
+    followed by fdatasync(). A sidecar index file "<record>.idx" stores one
+    index_entry per chunk. It is only a cache: a torn chunk at the end of a
+    record file or a missing/short index is detected and repaired by
+    record_recover().
+
+    Timestamps are CLOCK_REALTIME, which steps backwards on NTP or RTC
+    corrections. Rows and chunks are stored in recording order, so a
+    chunk is not necessarily later than its predecessor and its first and
+    last row are not necessarily its earliest and latest one.
+
+    Copyright (C) 2026 Beckhoff Automation GmbH & Co. KG
+*/
+
+#ifndef _BBAPI_RECORDER_H_
+#define _BBAPI_RECORDER_H_
+
+#include "bbapi_client.h"
+#include <stddef.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#define RECORD_MAGIC "BBAPIREC"
+#define RECORD_VERSION 1
+#define RECORD_CHUNK_MAGIC 0x4b434242	/* "BBCK" */
+#define RECORD_MAX_COLUMNS 64
+#define RECORD_MAX_CHUNK_SIZE (16 * 1024 * 1024)
+#define RECORD_NAME_SIZE 32
+#define RECORD_INDEX_SUFFIX ".idx"
+
+struct file_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t num_columns;
+};
+
+struct column_desc {
+	char name[RECORD_NAME_SIZE];
+	uint32_t group;
+	uint32_t offset;
+	uint32_t size;
+	uint32_t is_signed;
+};
+
+struct chunk_header {
+	uint32_t magic;
+	uint32_t payload_size;
+	uint32_t num_rows;
+	uint32_t crc;
+	int64_t first_us;
+	int64_t last_us;
+};
+
+/**
+ * struct index_entry - location and time range of a chunk
+ * @min_us: earliest timestamp of the chunk
+ * @max_us: latest timestamp of the chunk
+ * @offset: file offset of the chunk_header
+ * @num_rows: number of rows of the chunk
+ * @crc: CRC32 of all previous members
+ */
+struct index_entry {
+	int64_t min_us;
+	int64_t max_us;
+	uint64_t offset;
+	uint32_t num_rows;
+	uint32_t crc;
+};
+
+/**
+ * struct chunk - a decoded chunk
+ * @time_us: timestamps in microseconds since the epoch
+ * @values: values[column][row]
+ * @valid: valid[column][row] is false, if reading that value failed
+ */
+struct chunk {
+	std::vector < int64_t > time_us;
+	std::vector < std::vector < int64_t > >values;
+	std::vector < std::vector < bool > >valid;
+
+	void reset(size_t num_columns) {
+		time_us.clear();
+		values.assign(num_columns, std::vector < int64_t > ());
+		valid.assign(num_columns, std::vector < bool > ());
+	}
+};
+
+static inline uint32_t record_crc32(const void *data, size_t len,
+				    uint32_t crc = 0)
+{
+	static uint32_t table[256];
+	const uint8_t *p = (const uint8_t *)data;
+
+	if (!table[1]) {
+		for (uint32_t i = 0; i < 256; ++i) {
+			uint32_t c = i;
+			for (int k = 0; k < 8; ++k) {
+				c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+			}
+			table[i] = c;
+		}
+	}
+
+	crc = ~crc;
+	while (len--) {
+		crc = table[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+static inline void varint_put(std::string & out, uint64_t value)
+{
+	while (value >= 0x80) {
+		out.push_back((char)(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back((char)value);
+}
+
+static inline void zigzag_put(std::string & out, int64_t value)
+{
+	varint_put(out, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+static inline bool varint_get(const uint8_t ** pos, const uint8_t * end,
+			      uint64_t * value)
+{
+	uint64_t result = 0;
+	for (unsigned shift = 0; shift < 64 && *pos < end; shift += 7) {
+		const uint8_t byte = *(*pos)++;
+		result |= (uint64_t)(byte & 0x7f) << shift;
+		if (!(byte & 0x80)) {
+			*value = result;
+			return true;
+		}
+	}
+	return false;
+}
+
+static inline bool zigzag_get(const uint8_t ** pos, const uint8_t * end,
+			      int64_t * value)
+{
+	uint64_t raw;
+	if (!varint_get(pos, end, &raw)) {
+		return false;
+	}
+	*value = (int64_t)(raw >> 1) ^ -(int64_t)(raw & 1);
+	return true;
+}
+
+/**
+ * chunk_encode() - serialize a chunk into header + payload
+ */
+static inline void chunk_encode(const struct chunk *c,
+				struct chunk_header *hdr, std::string & payload)
+{
+	const size_t rows = c->time_us.size();
+	int64_t prev = rows ? c->time_us[0] : 0;
+
+	payload.clear();
+	for (size_t row = 0; row < rows; ++row) {
+		zigzag_put(payload, c->time_us[row] - prev);
+		prev = c->time_us[row];
+	}
+
+	for (size_t col = 0; col < c->values.size(); ++col) {
+		size_t missing = 0;
+		for (size_t row = 0; row < rows; ++row) {
+			missing += !c->valid[col][row];
+		}
+
+		varint_put(payload, missing);
+		size_t prev_row = 0;
+		for (size_t row = 0; row < rows; ++row) {
+			if (!c->valid[col][row]) {
+				varint_put(payload, row - prev_row);
+				prev_row = row;
+			}
+		}
+
+		prev = 0;
+		for (size_t row = 0; row < rows; ++row) {
+			if (c->valid[col][row]) {
+				zigzag_put(payload, c->values[col][row] - prev);
+				prev = c->values[col][row];
+			}
+		}
+	}
+
+	hdr->magic = RECORD_CHUNK_MAGIC;
+	hdr->payload_size = payload.size();
+	hdr->num_rows = rows;
+	hdr->crc = record_crc32(payload.data(), payload.size());
+	hdr->first_us = rows ? c->time_us[0] : 0;
+	hdr->last_us = rows ? c->time_us[rows - 1] : 0;
+}
+
+/**
+ * chunk_decode() - parse a chunk payload
+ *
+ * Return: false if the payload is corrupted
+ */
+static inline bool chunk_decode(const struct chunk_header *hdr,
+				const uint8_t * payload, size_t num_columns,
+				struct chunk *c)
+{
+	const uint8_t *pos = payload;
+	const uint8_t *const end = payload + hdr->payload_size;
+	int64_t prev = hdr->first_us;
+
+	c->reset(num_columns);
+	c->time_us.resize(hdr->num_rows);
+	for (uint32_t row = 0; row < hdr->num_rows; ++row) {
+		int64_t delta;
+		if (!zigzag_get(&pos, end, &delta)) {
+			return false;
+		}
+		prev += delta;
+		c->time_us[row] = prev;
+	}
+
+	for (size_t col = 0; col < num_columns; ++col) {
+		uint64_t missing;
+		uint64_t row = 0;
+
+		c->valid[col].assign(hdr->num_rows, true);
+		c->values[col].assign(hdr->num_rows, 0);
+		if (!varint_get(&pos, end, &missing) || missing > hdr->num_rows) {
+			return false;
+		}
+
+		while (missing--) {
+			uint64_t delta;
+			if (!varint_get(&pos, end, &delta)
+			    || row + delta >= hdr->num_rows) {
+				return false;
+			}
+			row += delta;
+			c->valid[col][row] = false;
+		}
+
+		prev = 0;
+		for (row = 0; row < hdr->num_rows; ++row) {
+			int64_t delta;
+			if (!c->valid[col][row]) {
+				continue;
+			}
+			if (!zigzag_get(&pos, end, &delta)) {
+				return false;
+			}
+			prev += delta;
+			c->values[col][row] = prev;
+		}
+	}
+	return pos == end;
+}
+
+static inline bool pread_full(int fd, void *buf, size_t len, off_t off)
+{
+	uint8_t *p = (uint8_t *) buf;
+	while (len) {
+		const ssize_t n = pread(fd, p, len, off);
+		if (n <= 0) {
+			if (n < 0 && EINTR == errno) {
+				continue;
+			}
+			return false;
+		}
+		p += n;
+		off += n;
+		len -= n;
+	}
+	return true;
+}
+
+static inline bool write_full(int fd, const void *buf, size_t len)
+{
+	const uint8_t *p = (const uint8_t *)buf;
+	while (len) {
+		const ssize_t n = write(fd, p, len);
+		if (n < 0) {
+			if (EINTR == errno) {
+				continue;
+			}
+			return false;
+		}
+		p += n;
+		len -= n;
+	}
+	return true;
+}
+
+/**
+ * record_read_chunk() - read and verify the chunk at @off
+ * @payload: receives the raw payload, may be NULL
+ *
+ * Only the structure and the CRC are verified. The timestamps are not,
+ * a clock step backwards doesn't make a chunk invalid.
+ *
+ * Return: true if a complete and valid chunk was found
+ */
+static inline bool record_read_chunk(int fd, off_t off,
+				     struct chunk_header *hdr,
+				     std::string * payload)
+{
+	if (!pread_full(fd, hdr, sizeof(*hdr), off)
+	    || RECORD_CHUNK_MAGIC != hdr->magic
+	    || hdr->payload_size > RECORD_MAX_CHUNK_SIZE) {
+		return false;
+	}
+
+	std::string local;
+	std::string & buf = payload ? *payload : local;
+	buf.resize(hdr->payload_size);
+	if (!pread_full(fd, &buf[0], hdr->payload_size, off + sizeof(*hdr))) {
+		return false;
+	}
+	return hdr->crc == record_crc32(buf.data(), buf.size());
+}
+
+static inline uint32_t index_entry_crc(const struct index_entry *e)
+{
+	return record_crc32(e, offsetof(struct index_entry, crc));
+}
+
+/**
+ * chunk_time_range() - earliest and latest timestamp of a chunk
+ *
+ * Only the timestamp column of the payload is decoded.
+ *
+ * Return: false if the payload is corrupted
+ */
+static inline bool chunk_time_range(const struct chunk_header *hdr,
+				    const std::string & payload,
+				    int64_t * min_us, int64_t * max_us)
+{
+	const uint8_t *pos = (const uint8_t *)payload.data();
+	const uint8_t *const end = pos + payload.size();
+	int64_t t = hdr->first_us;
+
+	*min_us = t;
+	*max_us = t;
+	for (uint32_t row = 0; row < hdr->num_rows; ++row) {
+		int64_t delta;
+		if (!zigzag_get(&pos, end, &delta)) {
+			return false;
+		}
+		t += delta;
+		*min_us = std::min(*min_us, t);
+		*max_us = std::max(*max_us, t);
+	}
+	return true;
+}
+
+/**
+ * record_read_header() - read file header and column descriptions
+ *
+ * Return: offset of the first chunk or -1 if the header is invalid
+ */
+static inline off_t record_read_header(int fd,
+				       std::vector < struct column_desc >&columns)
+{
+	struct file_header hdr;
+
+	if (!pread_full(fd, &hdr, sizeof(hdr), 0)
+	    || memcmp(hdr.magic, RECORD_MAGIC, sizeof(hdr.magic))
+	    || RECORD_VERSION != hdr.version
+	    || !hdr.num_columns || hdr.num_columns > RECORD_MAX_COLUMNS) {
+		return -1;
+	}
+
+	columns.resize(hdr.num_columns);
+	if (!pread_full(fd, &columns[0], columns.size() * sizeof(columns[0]),
+			sizeof(hdr))) {
+		return -1;
+	}
+	return sizeof(hdr) + columns.size() * sizeof(columns[0]);
+}
+
+/**
+ * record_recover() - build the chunk index of a record file
+ * @fd: record file
+ * @idx_fd: index file, entries beyond the valid part are rewritten.
+ *          Pass -1 to work read-only.
+ * @data_start: offset of the first chunk
+ * @index: receives one entry per valid chunk
+ *
+ * Trusted index entries are verified by their own CRC and the chunk
+ * header they point to. Chunks behind the last indexed one are verified
+ * completely. Scanning stops at the first damaged chunk, which marks the
+ * end of the valid data.
+ *
+ * Return: offset behind the last valid chunk
+ */
+static inline off_t record_recover(int fd, int idx_fd, off_t data_start,
+				   std::vector < struct index_entry >&index)
+{
+	off_t end = data_start;
+	struct index_entry e;
+	struct chunk_header hdr;
+
+	index.clear();
+	if (-1 != idx_fd) {
+		off_t idx_off = 0;
+		while (pread_full(idx_fd, &e, sizeof(e), idx_off)
+		       && e.crc == index_entry_crc(&e)
+		       && (off_t) e.offset == end
+		       && pread_full(fd, &hdr, sizeof(hdr), e.offset)
+		       && RECORD_CHUNK_MAGIC == hdr.magic
+		       && hdr.num_rows == e.num_rows
+		       && e.min_us <= hdr.first_us && hdr.first_us <= e.max_us) {
+			index.push_back(e);
+			end += sizeof(hdr) + hdr.payload_size;
+			idx_off += sizeof(e);
+		}
+	}
+
+	/* the last indexed chunk might have been torn after its index entry */
+	if (!index.empty()
+	    && !record_read_chunk(fd, index.back().offset, &hdr, NULL)) {
+		end = index.back().offset;
+		index.pop_back();
+	}
+
+	const size_t indexed = index.size();
+	std::string payload;
+	while (record_read_chunk(fd, end, &hdr, &payload)
+	       && chunk_time_range(&hdr, payload, &e.min_us, &e.max_us)) {
+		e.offset = end;
+		e.num_rows = hdr.num_rows;
+		e.crc = index_entry_crc(&e);
+		index.push_back(e);
+		end += sizeof(hdr) + hdr.payload_size;
+	}
+
+	if (-1 != idx_fd) {
+		const off_t idx_end = indexed * sizeof(e);
+		if (ftruncate(idx_fd, idx_end)
+		    || -1 == lseek(idx_fd, idx_end, SEEK_SET)
+		    || !write_full(idx_fd, index.data() + indexed,
+				   (index.size() - indexed) * sizeof(e))) {
+			perror("repair index");
+		}
+	}
+	return end;
+}
+
+#endif /* #ifndef _BBAPI_RECORDER_H_ */
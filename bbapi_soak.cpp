@@ -0,0 +1,643 @@
+// SPDX-License-Identifier: MIT
+/**
+    Long-running concurrency soak test for all BBAPI device nodes
+
+    usage: bbapi_soak [options] [-w <target>=<processes>]...
+
+    Forks worker processes which hammer one device node each:
+      bbapi     random reads of all supported values and SENSORINFOs,
+                reopening the device every 1000 calls
+      display   full screen writes to /dev/cx_display
+      watchdog  keepalive, gettimeout and getstatus on /dev/watchdog
+                (at most one process, disarmed by magic close at the end)
+      button    open, EVIOCGKEY, EVIOCGABS and close of the CX2100 button
+                input device (each open/close starts/stops its poll timer)
+      pwrfail   sample the sups_pwrfail GPIO line, all processes share one
+                line handle requested by the parent (-G: read a sysfs
+                value file instead)
+    Workers account their calls, errors and a latency histogram in shared
+    memory. Every interval the parent prints one CSV line per target with
+    throughput, p50/p99/p99.9/max latency and errors together with the
+    kernel memory counters from /proc/meminfo. The final summary reports
+    the kernel memory growth over the whole run. The exit code is 1 if any
+    error occurred, a worker failed to open its device or the growth
+    exceeds the limit given with -M.
+
+    WARNING: if this tool is killed by SIGKILL while a watchdog worker
+    is running, the watchdog is not disarmed and will reset the system.
+
+    Copyright (C) 2026 Beckhoff Automation GmbH & Co. KG
+*/
+
+#include "bbapi_client.h"
+#include <algorithm>
+#include <signal.h>
+#include <string>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#ifndef __FreeBSD__
+#include <linux/input.h>
+#include <linux/watchdog.h>
+#endif /* #ifndef __FreeBSD__ */
+
+#define NUM_BUCKETS 192
+#define REOPEN_INTERVAL 1000
+
+enum target {
+	TARGET_BBAPI,
+	TARGET_DISPLAY,
+	TARGET_WATCHDOG,
+	TARGET_BUTTON,
+	TARGET_PWRFAIL,
+	NUM_TARGETS
+};
+
+static const char *const TARGET_NAMES[NUM_TARGETS] = {
+	"bbapi", "display", "watchdog", "button", "pwrfail",
+};
+
+/**
+ * struct worker_stats - counters shared between a worker and the parent
+ *
+ * Only the worker writes, the parent takes snapshots and resets
+ * @interval_max_ns. All accesses are relaxed atomics, consistency between
+ * the counters is not required.
+ */
+struct worker_stats {
+	uint64_t calls;
+	uint64_t errors;
+	uint64_t max_ns;
+	uint64_t interval_max_ns;
+	uint64_t histogram[NUM_BUCKETS];
+};
+
+/**
+ * struct shared_state - header of the shared memory, followed by one
+ * struct worker_stats per worker process
+ */
+struct shared_state {
+	volatile sig_atomic_t stop;
+	uint32_t num_workers;
+	uint64_t reserved;
+};
+
+struct meminfo {
+	long slab_kb;
+	long sunreclaim_kb;
+	long vmalloc_kb;
+	long kernel_stack_kb;
+};
+
+static struct shared_state *g_shared;
+static struct worker_stats *g_workers;
+static const char *g_paths[NUM_TARGETS];
+static int g_pwrfail_fd = -1;
+static int g_pwrfail_error = ENODEV;
+
+static void on_signal(int sig)
+{
+	g_shared->stop = 1;
+}
+
+/**
+ * latency_bucket() - log-linear histogram with 4 sub-buckets per power of two
+ */
+static size_t latency_bucket(uint64_t ns)
+{
+	if (ns < 16) {
+		return ns;
+	}
+	const int msb = 63 - __builtin_clzll(ns);
+	const size_t bucket = 16 + (msb - 4) * 4 + ((ns >> (msb - 2)) & 3);
+	return bucket < NUM_BUCKETS ? bucket : NUM_BUCKETS - 1;
+}
+
+static uint64_t bucket_upper_ns(size_t bucket)
+{
+	if (bucket < 16) {
+		return bucket;
+	}
+	const int msb = (bucket - 16) / 4 + 4;
+	const uint64_t sub = (bucket - 16) % 4;
+	return ((4 + sub + 1) << (msb - 2)) - 1;
+}
+
+static void account(struct worker_stats *s, uint64_t start, bool ok)
+{
+	const uint64_t ns = bbapi_clock_ns() - start;
+
+	__atomic_add_fetch(&s->calls, 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&s->histogram[latency_bucket(ns)], 1,
+			   __ATOMIC_RELAXED);
+	if (!ok) {
+		__atomic_add_fetch(&s->errors, 1, __ATOMIC_RELAXED);
+	}
+	if (ns > __atomic_load_n(&s->max_ns, __ATOMIC_RELAXED)) {
+		__atomic_store_n(&s->max_ns, ns, __ATOMIC_RELAXED);
+	}
+	if (ns > __atomic_load_n(&s->interval_max_ns, __ATOMIC_RELAXED)) {
+		__atomic_store_n(&s->interval_max_ns, ns, __ATOMIC_RELAXED);
+	}
+}
+
+/**
+ * open_failed() - count a failed open() as error, without a latency sample
+ *
+ * Return: false, for the worker to give up
+ */
+static bool open_failed(struct worker_stats *s, const char *path)
+{
+	perror(path);
+	__atomic_add_fetch(&s->errors, 1, __ATOMIC_RELAXED);
+	return false;
+}
+
+/*
+ * The soak_*() workers return false if they gave up early, because the
+ * device couldn't be opened.
+ */
+static bool soak_bbapi(struct worker_stats *s)
+{
+	std::vector < struct bbapi_value >values;
+	uint32_t num_sensors = 0;
+	int64_t value;
+	int fd = open(g_paths[TARGET_BBAPI], O_RDWR);
+
+	if (-1 == fd) {
+		return open_failed(s, g_paths[TARGET_BBAPI]);
+	}
+
+	/* only hammer what this board supports, errors are real errors then */
+	for (size_t i = 0; i < BBAPI_NUM_VALUES; ++i) {
+		if (!bbapi_read_value(fd, &BBAPI_VALUES[i], &value)) {
+			values.push_back(BBAPI_VALUES[i]);
+		}
+	}
+	bbapi_ioctl_read(fd, BIOSIGRP_SYSTEM, BIOSIOFFS_SYSTEM_COUNT_SENSORS,
+			 &num_sensors, sizeof(num_sensors));
+
+	for (uint64_t i = 0; !g_shared->stop; ++i) {
+		const size_t n = values.size() + num_sensors;
+		const size_t pick = n ? random() % n : 0;
+		uint64_t start = bbapi_clock_ns();
+		bool ok;
+
+		if (!n) {
+			ok = !bbapi_ioctl_read(fd, BIOSIGRP_SYSTEM,
+					       BIOSIOFFS_SYSTEM_COUNT_SENSORS,
+					       &num_sensors,
+					       sizeof(num_sensors));
+		} else if (pick < values.size()) {
+			ok = !bbapi_read_value(fd, &values[pick], &value);
+		} else {
+			SENSORINFO info;
+			ok = !bbapi_ioctl_read(fd, BIOSIGRP_SYSTEM,
+					       pick - values.size() + 1, &info,
+					       sizeof(info));
+		}
+		account(s, start, ok);
+
+		if (i % REOPEN_INTERVAL == REOPEN_INTERVAL - 1) {
+			start = bbapi_clock_ns();
+			close(fd);
+			fd = open(g_paths[TARGET_BBAPI], O_RDWR);
+			account(s, start, -1 != fd);
+			if (-1 == fd) {
+				perror(g_paths[TARGET_BBAPI]);
+				return false;
+			}
+		}
+	}
+	close(fd);
+	return true;
+}
+
+static bool soak_display(struct worker_stats *s)
+{
+	const int fd = open(g_paths[TARGET_DISPLAY], O_WRONLY);
+	char screen[64];
+
+	if (-1 == fd) {
+		return open_failed(s, g_paths[TARGET_DISPLAY]);
+	}
+
+	while (!g_shared->stop) {
+		snprintf(screen, sizeof(screen), "\f%08lx%08lx\n%016lx",
+			 random(), random(), (long)getpid());
+		const size_t len = strlen(screen);
+		const uint64_t start = bbapi_clock_ns();
+		account(s, start, (ssize_t) len == write(fd, screen, len));
+	}
+	close(fd);
+	return true;
+}
+
+static bool soak_watchdog(struct worker_stats *s)
+{
+#ifdef WDIOC_KEEPALIVE
+	const int fd = open(g_paths[TARGET_WATCHDOG], O_WRONLY);
+	int timeout = 60;
+
+	if (-1 == fd) {
+		return open_failed(s, g_paths[TARGET_WATCHDOG]);
+	}
+
+	uint64_t start = bbapi_clock_ns();
+	account(s, start, !ioctl(fd, WDIOC_SETTIMEOUT, &timeout));
+	while (!g_shared->stop) {
+		int value;
+		start = bbapi_clock_ns();
+		account(s, start, !ioctl(fd, WDIOC_KEEPALIVE, 0));
+		start = bbapi_clock_ns();
+		account(s, start, !ioctl(fd, WDIOC_GETTIMEOUT, &value)
+			&& 60 == value);
+		start = bbapi_clock_ns();
+		account(s, start, !ioctl(fd, WDIOC_GETSTATUS, &value));
+	}
+
+	if (1 != write(fd, "V", 1)) {
+		perror("watchdog magic close");
+	}
+	close(fd);
+#endif
+	return true;
+}
+
+static bool soak_button(struct worker_stats *s)
+{
+#ifdef EVIOCGKEY
+	while (!g_shared->stop) {
+		uint8_t keys[KEY_MAX / 8 + 1];
+		struct input_absinfo abs;
+		const uint64_t start = bbapi_clock_ns();
+		const int fd = open(g_paths[TARGET_BUTTON], O_RDONLY | O_NONBLOCK);
+		bool ok = -1 != fd;
+
+		if (ok) {
+			ok = ioctl(fd, EVIOCGKEY(sizeof(keys)), keys) >= 0
+			    && !ioctl(fd, EVIOCGABS(ABS_X), &abs)
+			    && !ioctl(fd, EVIOCGABS(ABS_Y), &abs);
+			close(fd);
+		}
+		account(s, start, ok);
+	}
+#endif
+	return true;
+}
+
+static bool soak_pwrfail(struct worker_stats *s)
+{
+	const char *const sysfs = g_paths[TARGET_PWRFAIL];
+	const int fd = sysfs ? open(sysfs, O_RDONLY) : g_pwrfail_fd;
+
+	if (-1 == fd) {
+		if (!sysfs) {
+			errno = g_pwrfail_error;
+		}
+		return open_failed(s, sysfs ? sysfs : BBAPI_PWRFAIL_LINE);
+	}
+
+	while (!g_shared->stop) {
+		const uint64_t start = bbapi_clock_ns();
+		bool ok;
+
+		if (sysfs) {
+			char value[4];
+			ok = pread(fd, value, sizeof(value), 0) > 0
+			    && ('0' == value[0] || '1' == value[0]);
+		} else {
+#ifndef __FreeBSD__
+			ok = -1 != bbapi_gpio_read_line(fd);
+#else
+			ok = false;
+#endif
+		}
+		account(s, start, ok);
+	}
+	if (sysfs) {
+		close(fd);
+	}
+	return true;
+}
+
+static bool (*const SOAK_FUNCS[NUM_TARGETS]) (struct worker_stats *) = {
+	soak_bbapi, soak_display, soak_watchdog, soak_button, soak_pwrfail,
+};
+
+static bool read_meminfo(struct meminfo *m)
+{
+	FILE *const f = fopen("/proc/meminfo", "r");
+	char line[128];
+
+	memset(m, 0, sizeof(*m));
+	if (!f) {
+		return false;
+	}
+	while (fgets(line, sizeof(line), f)) {
+		sscanf(line, "Slab: %ld", &m->slab_kb);
+		sscanf(line, "SUnreclaim: %ld", &m->sunreclaim_kb);
+		sscanf(line, "VmallocUsed: %ld", &m->vmalloc_kb);
+		sscanf(line, "KernelStack: %ld", &m->kernel_stack_kb);
+	}
+	fclose(f);
+	return true;
+}
+
+struct target_snapshot {
+	uint64_t calls;
+	uint64_t errors;
+	uint64_t max_ns;
+	uint64_t interval_max_ns;
+	uint64_t histogram[NUM_BUCKETS];
+};
+
+static void snapshot(struct worker_stats *w, struct target_snapshot *t)
+{
+	t->calls += __atomic_load_n(&w->calls, __ATOMIC_RELAXED);
+	t->errors += __atomic_load_n(&w->errors, __ATOMIC_RELAXED);
+	t->max_ns = std::max(t->max_ns,
+			     __atomic_load_n(&w->max_ns, __ATOMIC_RELAXED));
+	t->interval_max_ns =
+	    std::max(t->interval_max_ns,
+		     __atomic_exchange_n(&w->interval_max_ns, 0,
+					 __ATOMIC_RELAXED));
+	for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+		t->histogram[i] += __atomic_load_n(&w->histogram[i],
+						   __ATOMIC_RELAXED);
+	}
+}
+
+static uint64_t percentile_ns(const uint64_t * histogram, uint64_t count,
+			      double p)
+{
+	const uint64_t target = p * count;
+	uint64_t sum = 0;
+
+	for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+		sum += histogram[i];
+		if (sum > target) {
+			return bucket_upper_ns(i);
+		}
+	}
+	return 0;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+		"usage: %s [options] [-w <target>=<processes>]...\n\n"
+		" -w  number of worker processes per target (default: bbapi=4)\n"
+		"     targets: bbapi, display, watchdog (max. 1), button, pwrfail\n"
+		" -d  duration in seconds (default: 3600)\n"
+		" -i  report interval in seconds (default: 10)\n"
+		" -o  write the interval reports as CSV to file instead of stdout\n"
+		" -M  max. tolerated kernel memory growth in kB (default: 1024)\n"
+		" -b  bbapi device (default: " BBAPI_DEVICE ")\n"
+		" -D  display device (default: /dev/cx_display)\n"
+		" -W  watchdog device (default: /dev/watchdog)\n"
+		" -B  button event device (default: detected by name)\n"
+		" -G  read this sysfs value file instead of the GPIO line '"
+		BBAPI_PWRFAIL_LINE "'\n",
+		name);
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned processes[NUM_TARGETS] = { 0 };
+	std::vector < pid_t > pids;
+	std::vector < int >worker_target;
+	const std::string button = bbapi_find_button_device();
+	const char *output = NULL;
+	double duration = 3600;
+	double interval = 10;
+	long max_growth_kb = 1024;
+	bool any = false;
+	int opt;
+
+	g_paths[TARGET_BBAPI] = BBAPI_DEVICE;
+	g_paths[TARGET_DISPLAY] = "/dev/cx_display";
+	g_paths[TARGET_WATCHDOG] = "/dev/watchdog";
+	g_paths[TARGET_BUTTON] = button.c_str();
+	g_paths[TARGET_PWRFAIL] = NULL;
+
+	while ((opt = getopt(argc, argv, "w:d:i:o:M:b:D:W:B:G:h")) != -1) {
+		switch (opt) {
+		case 'w':{
+				const std::string arg(optarg);
+				const std::string name = arg.substr(0, arg.find('='));
+				size_t t = 0;
+				while (t < NUM_TARGETS && name != TARGET_NAMES[t]) {
+					++t;
+				}
+				if (t == NUM_TARGETS || name == arg) {
+					fprintf(stderr, "invalid worker '%s'\n",
+						optarg);
+					return -1;
+				}
+				processes[t] = strtoul(optarg + name.size() + 1,
+						       NULL, 0);
+				any = true;
+				break;
+			}
+		case 'd':
+			duration = atof(optarg);
+			break;
+		case 'i':
+			interval = atof(optarg);
+			break;
+		case 'o':
+			output = optarg;
+			break;
+		case 'M':
+			max_growth_kb = atol(optarg);
+			break;
+		case 'b':
+			g_paths[TARGET_BBAPI] = optarg;
+			break;
+		case 'D':
+			g_paths[TARGET_DISPLAY] = optarg;
+			break;
+		case 'W':
+			g_paths[TARGET_WATCHDOG] = optarg;
+			break;
+		case 'B':
+			g_paths[TARGET_BUTTON] = optarg;
+			break;
+		case 'G':
+			g_paths[TARGET_PWRFAIL] = optarg;
+			break;
+		default:
+			usage(argv[0]);
+			return -1;
+		}
+	}
+
+	if (!any) {
+		processes[TARGET_BBAPI] = 4;
+	}
+	if (processes[TARGET_WATCHDOG] > 1) {
+		fprintf(stderr, "/dev/watchdog can be opened only once\n");
+		return -1;
+	}
+	if (argc != optind || duration <= 0 || interval <= 0) {
+		usage(argv[0]);
+		return -1;
+	}
+
+	for (size_t t = 0; t < NUM_TARGETS; ++t) {
+		worker_target.insert(worker_target.end(), processes[t], t);
+	}
+	if (worker_target.empty()) {
+		usage(argv[0]);
+		return -1;
+	}
+
+	const size_t shared_size = sizeof(struct shared_state)
+	    + worker_target.size() * sizeof(struct worker_stats);
+	g_shared = (struct shared_state *)mmap(NULL, shared_size,
+					       PROT_READ | PROT_WRITE,
+					       MAP_SHARED | MAP_ANONYMOUS, -1,
+					       0);
+	if (MAP_FAILED == g_shared) {
+		perror("mmap");
+		return -1;
+	}
+	memset(g_shared, 0, shared_size);
+	g_shared->num_workers = worker_target.size();
+	g_workers = (struct worker_stats *)(g_shared + 1);
+	signal(SIGINT, on_signal);
+	signal(SIGTERM, on_signal);
+
+	FILE *const out = output ? fopen(output, "w") : stdout;
+	if (!out) {
+		perror(output);
+		return -1;
+	}
+
+#ifndef __FreeBSD__
+	/* a GPIO line can be requested only once, the workers share it */
+	if (processes[TARGET_PWRFAIL] && !g_paths[TARGET_PWRFAIL]) {
+		std::string chip;
+		uint32_t offset;
+
+		if (bbapi_gpio_find_line(BBAPI_PWRFAIL_LINE, &chip, &offset)) {
+			g_pwrfail_fd =
+			    bbapi_gpio_request_line(chip.c_str(), offset,
+						    "bbapi_soak", 0);
+			g_pwrfail_error = errno;
+		} else {
+			g_pwrfail_error = ENOENT;
+		}
+	}
+#endif /* #ifndef __FreeBSD__ */
+
+	struct meminfo first;
+	read_meminfo(&first);
+	struct meminfo mem = first;
+
+	for (size_t i = 0; i < worker_target.size(); ++i) {
+		const pid_t pid = fork();
+		if (!pid) {
+			srandom(getpid());
+			_exit(SOAK_FUNCS[worker_target[i]] (&g_workers[i]) ?
+			      0 : 1);
+		}
+		if (pid < 0) {
+			perror("fork");
+			g_shared->stop = 1;
+			break;
+		}
+		pids.push_back(pid);
+	}
+
+	fprintf(out, "elapsed_s,target,calls_per_sec,p50_ns,p99_ns,p999_ns,"
+		"max_ns,errors,slab_kb,sunreclaim_kb,vmalloc_kb,kernel_stack_kb\n");
+
+	std::vector < struct target_snapshot >prev(NUM_TARGETS);
+	memset(&prev[0], 0, prev.size() * sizeof(prev[0]));
+	const uint64_t start = bbapi_clock_ns();
+	uint64_t last = start;
+	uint64_t errors = 0;
+
+	while (!g_shared->stop) {
+		const uint64_t next = last + interval * 1e9;
+		const uint64_t end = start + duration * 1e9;
+		const uint64_t wakeup = std::min(next, end);
+		struct timespec ts = {
+			(time_t)(wakeup / 1000000000ULL),
+			(long)(wakeup % 1000000000ULL)
+		};
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+
+		const uint64_t now = bbapi_clock_ns();
+		std::vector < struct target_snapshot >cur(NUM_TARGETS);
+		memset(&cur[0], 0, cur.size() * sizeof(cur[0]));
+		for (size_t i = 0; i < worker_target.size(); ++i) {
+			snapshot(&g_workers[i], &cur[worker_target[i]]);
+		}
+		read_meminfo(&mem);
+
+		errors = 0;
+		for (size_t t = 0; t < NUM_TARGETS; ++t) {
+			uint64_t hist[NUM_BUCKETS];
+			const uint64_t calls = cur[t].calls - prev[t].calls;
+
+			errors += cur[t].errors;
+			if (!processes[t]) {
+				continue;
+			}
+			for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+				hist[i] = cur[t].histogram[i] - prev[t].histogram[i];
+			}
+			fprintf(out, "%.1f,%s,%.1f,%llu,%llu,%llu,%llu,%llu,"
+				"%ld,%ld,%ld,%ld\n", (now - start) / 1e9,
+				TARGET_NAMES[t], calls * 1e9 / (now - last),
+				(unsigned long long)percentile_ns(hist, calls, 0.5),
+				(unsigned long long)percentile_ns(hist, calls, 0.99),
+				(unsigned long long)percentile_ns(hist, calls, 0.999),
+				(unsigned long long)cur[t].interval_max_ns,
+				(unsigned long long)(cur[t].errors - prev[t].errors),
+				mem.slab_kb, mem.sunreclaim_kb, mem.vmalloc_kb,
+				mem.kernel_stack_kb);
+		}
+		fflush(out);
+		prev.swap(cur);
+		last = now;
+		if (now >= end) {
+			break;
+		}
+	}
+
+	g_shared->stop = 1;
+	bool workers_ok = pids.size() == worker_target.size();
+	for (size_t i = 0; i < pids.size(); ++i) {
+		int status;
+		if (-1 == waitpid(pids[i], &status, 0) || !WIFEXITED(status)
+		    || WEXITSTATUS(status)) {
+			fprintf(stderr, "%s worker %d failed\n",
+				TARGET_NAMES[worker_target[i]], (int)pids[i]);
+			workers_ok = false;
+		}
+	}
+	if (output) {
+		fclose(out);
+	}
+
+	/* unreclaimable slab and vmalloc are what a driver leak grows */
+	const long growth_kb = (mem.sunreclaim_kb - first.sunreclaim_kb)
+	    + (mem.vmalloc_kb - first.vmalloc_kb);
+	printf("duration: %.1f s\n", (last - start) / 1e9);
+	for (size_t t = 0; t < NUM_TARGETS; ++t) {
+		if (processes[t]) {
+			printf("%-8s: %u process(es), %llu calls, %llu errors, "
+			       "max latency %llu ns\n", TARGET_NAMES[t],
+			       processes[t], (unsigned long long)prev[t].calls,
+			       (unsigned long long)prev[t].errors,
+			       (unsigned long long)prev[t].max_ns);
+		}
+	}
+	printf("kernel memory growth (SUnreclaim + VmallocUsed): %ld kB\n",
+	       growth_kb);
+	return (errors || !workers_ok || growth_kb > max_growth_kb) ? 1 : 0;
+}
@@ -0,0 +1,609 @@
+// SPDX-License-Identifier: MIT
+/**
+    Watchdog manager pinging bbapi_wdt on behalf of supervised processes
+
+    usage: bbapi_watchdogd [options] [-g <group>] [-r <name>:<ms>]... [-o <name>:<ms>]...
+           bbapi_watchdogd -b <name>
+           bbapi_watchdogd -d
+
+    Each source is a supervised process with a heartbeat counter in the
+    shared memory BBAPI_WATCHDOG_BEATS (see bbapi_watchdogd.h), writable
+    by the group given with -g. Sources are configured on the command
+    line only, BBAPI_WATCHDOG_SHM just exports their state. A source is
+    healthy while its counter changed within the last <ms> milliseconds,
+    the resolution of this check is the ping period. /dev/watchdog is only
+    pinged while all required (-r) sources are healthy, optional (-o)
+    sources are monitored for statistics only. Scripts can send a single
+    heartbeat with -b.
+
+    The daemon locks its memory and runs with SCHED_FIFO priority. The
+    latency of each ping (wakeup delay + WDIOC_KEEPALIVE) is measured and
+    a decaying maximum of it is used to keep two pings plus a safety margin
+    of 4 times that latency within the watchdog timeout: the ping period
+    is shortened down to -m first, then the timeout is raised up to -T.
+    After 60 s without need the timeout returns to -t. Statistics and the
+    state of all sources are exported through the shared memory and
+    printed with -d.
+
+    On SIGINT or SIGTERM the watchdog is disarmed by magic close, unless
+    -n is given.
+
+    Copyright (C) 2026 Beckhoff Automation GmbH & Co. KG
+*/
+
+#include "bbapi_client.h"
+#include "bbapi_watchdogd.h"
+#include <algorithm>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <linux/watchdog.h>
+#include <sys/file.h>
+
+#define NSEC_PER_SEC 1000000000ULL
+#define NSEC_PER_MSEC 1000000ULL
+#define DEFAULT_TIMEOUT_S 10
+#define DEFAULT_MAX_TIMEOUT_S 60
+#define DEFAULT_PERIOD_MS 1000
+#define DEFAULT_MIN_PERIOD_MS 100
+#define DEFAULT_PRIORITY 90
+#define SAFETY_FACTOR 4
+#define DECAY_SHIFT 6
+#define SHRINK_HOLDOFF_NS (60 * NSEC_PER_SEC)
+
+struct config {
+	const char *device;
+	int timeout_s;
+	int max_timeout_s;
+	uint64_t max_period_ns;
+	uint64_t min_period_ns;
+	int priority;
+	bool nowayout;
+};
+
+/**
+ * struct source_state - private bookkeeping of the daemon per source
+ * @src: configuration and state, only copied to the shared memory
+ * @last_change_ns: CLOCK_MONOTONIC of the last check with a new counter value
+ *
+ * Nothing is read back from the shared memory except the heartbeat
+ * counters, clients can't change the configuration of the daemon.
+ */
+struct source_state {
+	struct bbapi_watchdog_source src;
+	uint64_t last_change_ns;
+};
+
+static volatile sig_atomic_t g_stop;
+
+static void on_signal(int sig)
+{
+	g_stop = 1;
+}
+
+static void stats_write_begin(struct bbapi_watchdog_shm *shm)
+{
+	__atomic_store_n(&shm->stats.seq, shm->stats.seq + 1,
+			 __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void stats_write_end(struct bbapi_watchdog_shm *shm)
+{
+	__atomic_store_n(&shm->stats.seq, shm->stats.seq + 1,
+			 __ATOMIC_RELEASE);
+}
+
+static void stats_read(const struct bbapi_watchdog_shm *shm,
+		       struct bbapi_watchdog_stats *stats)
+{
+	uint32_t seq;
+
+	do {
+		seq = __atomic_load_n(&shm->stats.seq, __ATOMIC_ACQUIRE);
+		memcpy(stats, (const void *)&shm->stats, sizeof(*stats));
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	} while ((seq & 1)
+		 || seq != __atomic_load_n(&shm->stats.seq, __ATOMIC_RELAXED));
+}
+
+static bool add_source(std::vector < struct source_state >&state,
+		       const char *arg, bool required)
+{
+	const char *const sep = strrchr(arg, ':');
+	struct source_state st;
+	char *end;
+
+	if (!sep || sep == arg || sep - arg >= BBAPI_WATCHDOG_MAX_NAME
+	    || state.size() >= BBAPI_WATCHDOG_MAX_SOURCES) {
+		return false;
+	}
+
+	const unsigned long timeout_ms = strtoul(sep + 1, &end, 0);
+	if (*end || !timeout_ms || timeout_ms > UINT32_MAX) {
+		return false;
+	}
+
+	memset(&st, 0, sizeof(st));
+	memcpy(st.src.name, arg, sep - arg);
+	st.src.timeout_ms = timeout_ms;
+	st.src.required = required;
+	st.src.healthy = 1;
+	state.push_back(st);
+	return true;
+}
+
+/**
+ * check_sources() - sample all heartbeat counters
+ *
+ * Return: true if all required sources are healthy
+ */
+static bool check_sources(const struct bbapi_watchdog_beats *counters,
+			  std::vector < struct source_state >&state,
+			  uint64_t now)
+{
+	bool healthy = true;
+
+	for (size_t i = 0; i < state.size(); ++i) {
+		struct bbapi_watchdog_source *const s = &state[i].src;
+		const uint64_t beats =
+		    __atomic_load_n(&counters->beats[i], __ATOMIC_ACQUIRE);
+
+		if (beats != s->beats) {
+			s->beats = beats;
+			state[i].last_change_ns = now;
+		}
+
+		const uint64_t age_ms =
+		    (now - state[i].last_change_ns) / NSEC_PER_MSEC;
+		const bool ok = age_ms <= s->timeout_ms;
+		if (s->healthy && !ok) {
+			printf("%s source '%s' missed its heartbeat\n",
+			       s->required ? "required" : "optional", s->name);
+			fflush(stdout);
+			++s->misses;
+		} else if (!s->healthy && ok) {
+			printf("source '%s' is alive again\n", s->name);
+			fflush(stdout);
+		}
+		s->healthy = ok;
+		s->age_ms = std::min < uint64_t > (age_ms, UINT32_MAX);
+		healthy &= ok || !s->required;
+	}
+	return healthy;
+}
+
+/**
+ * adapt() - fit ping period and watchdog timeout to the observed latency
+ *
+ * Two pings and a margin of SAFETY_FACTOR times the recent ping latency
+ * have to fit into the timeout, so a single late ping never fires the
+ * watchdog. The period is shortened first, down to min_period_ns. Only if
+ * that is not enough the timeout is raised. A raised timeout is lowered
+ * again once the latency recovered for SHRINK_HOLDOFF_NS.
+ *
+ * Return: the new ping period
+ */
+static uint64_t adapt(const struct config *cfg, int fd,
+		      struct bbapi_watchdog_stats *stats,
+		      uint64_t * last_adjust_ns, uint64_t now)
+{
+	const uint64_t margin = SAFETY_FACTOR * stats->latency_recent_ns;
+	const uint64_t needed = 2 * cfg->min_period_ns + margin;
+	int want = std::max < int >(cfg->timeout_s,
+				    (needed + NSEC_PER_SEC - 1) / NSEC_PER_SEC);
+
+	want = std::min(want, cfg->max_timeout_s);
+	if (want > (int)stats->timeout_s
+	    || (want < (int)stats->timeout_s
+		&& now - *last_adjust_ns >= SHRINK_HOLDOFF_NS)) {
+		int timeout = want;
+		if (ioctl(fd, WDIOC_SETTIMEOUT, &timeout)) {
+			perror("WDIOC_SETTIMEOUT");
+		} else {
+			printf("timeout %u s -> %d s, recent ping latency %llu us\n",
+			       stats->timeout_s, timeout, (unsigned long long)
+			       stats->latency_recent_ns / 1000);
+			fflush(stdout);
+			stats->timeout_s = timeout;
+			++stats->adjustments;
+		}
+		*last_adjust_ns = now;
+	} else if (want == (int)stats->timeout_s) {
+		/* still needed, postpone the shrink */
+		*last_adjust_ns = now;
+	}
+
+	const uint64_t timeout_ns = stats->timeout_s * NSEC_PER_SEC;
+	const uint64_t period = timeout_ns > margin ? (timeout_ns - margin) / 2
+	    : 0;
+	return std::min(std::max(period, cfg->min_period_ns),
+			cfg->max_period_ns);
+}
+
+/**
+ * create_file() - create and map a shared memory file owned by the daemon
+ * @mode: permissions, set explicitly instead of relying on the umask
+ * @gid: group of the file or -1 to keep the group of the daemon
+ * @lock_fd: if not NULL, the file stays open and locked with flock()
+ *
+ * The file is always created with O_EXCL: a file left by someone else
+ * in the world writable /dev/shm is removed first, so nobody but the
+ * daemon owns the file or has it mapped writable. With @lock_fd a file
+ * locked by a running daemon is not removed.
+ *
+ * Return: mapping or NULL with errno set, EBUSY if another daemon runs
+ */
+static void *create_file(const char *path, size_t size, mode_t mode,
+			 gid_t gid, int *lock_fd)
+{
+	void *map;
+	int fd;
+
+	fd = open(path, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+	if (-1 != fd) {
+		// a running daemon holds the lock, a stale file is removed
+		// while we hold it
+		if (lock_fd && flock(fd, LOCK_EX | LOCK_NB)) {
+			close(fd);
+			errno = EBUSY;
+			return NULL;
+		}
+		const int err = unlink(path) ? errno : 0;
+		close(fd);
+		if (err && ENOENT != err) {
+			errno = err;
+			return NULL;
+		}
+	}
+
+	fd = open(path, O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC,
+		  mode);
+	if (-1 == fd) {
+		// lost the race against another daemon starting
+		errno = EEXIST == errno ? EBUSY : errno;
+		return NULL;
+	}
+	if ((lock_fd && flock(fd, LOCK_EX | LOCK_NB))
+	    || fchown(fd, (uid_t) - 1, gid) || fchmod(fd, mode)
+	    || ftruncate(fd, size)) {
+		const int err = errno;
+		close(fd);
+		unlink(path);
+		errno = err;
+		return NULL;
+	}
+	map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (MAP_FAILED == map) {
+		const int err = errno;
+		close(fd);
+		unlink(path);
+		errno = err;
+		return NULL;
+	}
+	if (lock_fd) {
+		*lock_fd = fd;
+	} else {
+		close(fd);
+	}
+	memset(map, 0, size);
+	return map;
+}
+
+/**
+ * lookup_group() - resolve a group name or number
+ *
+ * /etc/group is parsed directly, getgrnam() doesn't work in static
+ * binaries.
+ */
+static bool lookup_group(const char *name, gid_t * gid)
+{
+	char line[1024];
+	char *end;
+	bool found = false;
+
+	*gid = strtoul(name, &end, 0);
+	if (*name && !*end) {
+		return true;
+	}
+
+	FILE *const f = fopen("/etc/group", "re");
+	if (!f) {
+		return false;
+	}
+	while (!found && fgets(line, sizeof(line), f)) {
+		char *const sep = strchr(line, ':');
+		char *const gid_field = sep ? strchr(sep + 1, ':') : NULL;
+		if (!gid_field) {
+			continue;
+		}
+		*sep = 0;
+		if (!strcmp(line, name)) {
+			*gid = strtoul(gid_field + 1, &end, 10);
+			found = ':' == *end;
+		}
+	}
+	fclose(f);
+	return found;
+}
+
+static void publish_sources(struct bbapi_watchdog_shm *shm,
+			    const std::vector < struct source_state >&state)
+{
+	for (size_t i = 0; i < state.size(); ++i) {
+		shm->sources[i] = state[i].src;
+	}
+}
+
+static int dump(void)
+{
+	const struct bbapi_watchdog_shm *const shm = bbapi_watchdog_map();
+	struct bbapi_watchdog_stats stats;
+
+	if (!shm || (kill(shm->pid, 0) && ESRCH == errno)) {
+		fprintf(stderr, "bbapi_watchdogd is not running\n");
+		return -1;
+	}
+
+	stats_read(shm, &stats);
+	printf("pid:          %d\n", shm->pid);
+	printf("timeout:      %u s (%llu adjustments)\n", stats.timeout_s,
+	       (unsigned long long)stats.adjustments);
+	printf("period:       %u us\n", stats.period_us);
+	printf("pings:        %llu\n", (unsigned long long)stats.pings);
+	printf("skipped:      %llu\n", (unsigned long long)stats.skipped);
+	if (stats.pings) {
+		printf("latency:      min %llu us, mean %llu us, max %llu us, "
+		       "recent %llu us\n",
+		       (unsigned long long)stats.latency_min_ns / 1000,
+		       (unsigned long long)(stats.latency_sum_ns / stats.pings)
+		       / 1000, (unsigned long long)stats.latency_max_ns / 1000,
+		       (unsigned long long)stats.latency_recent_ns / 1000);
+	}
+	printf("\n%-32s %8s %10s %8s %10s %8s %14s\n", "source", "required",
+	       "timeout ms", "healthy", "age ms", "misses", "beats");
+	for (uint32_t i = 0; i < shm->num_sources; ++i) {
+		const struct bbapi_watchdog_source *const s = &shm->sources[i];
+		printf("%-32.*s %8s %10u %8s %10u %8llu %14llu\n",
+		       BBAPI_WATCHDOG_MAX_NAME, s->name,
+		       s->required ? "yes" : "no", s->timeout_ms,
+		       s->healthy ? "yes" : "no", s->age_ms,
+		       (unsigned long long)s->misses,
+		       (unsigned long long)s->beats);
+	}
+	return 0;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+		"usage: %s [options] [-r <name>:<ms>]... [-o <name>:<ms>]...\n"
+		"       %s -b <name>\n"
+		"       %s -d\n\n"
+		" -r  required source, ping only while it beats every <ms>\n"
+		" -o  optional source, monitored only\n"
+		" -t  watchdog timeout in seconds (default: %d)\n"
+		" -T  maximum timeout in seconds for adaption (default: %d)\n"
+		" -i  maximum ping period in ms (default: %d)\n"
+		" -m  minimum ping period in ms (default: %d)\n"
+		" -p  SCHED_FIFO priority (default: %d)\n"
+		" -w  watchdog device (default: /dev/watchdog)\n"
+		" -n  don't disarm the watchdog on exit\n"
+		" -g  group allowed to send heartbeats (default: none)\n"
+		" -b  send a single heartbeat for source <name>\n"
+		" -d  dump statistics of the running daemon\n",
+		name, name, name, DEFAULT_TIMEOUT_S, DEFAULT_MAX_TIMEOUT_S,
+		DEFAULT_PERIOD_MS, DEFAULT_MIN_PERIOD_MS, DEFAULT_PRIORITY);
+}
+
+int main(int argc, char *argv[])
+{
+	struct config cfg = {
+		"/dev/watchdog",
+		DEFAULT_TIMEOUT_S,
+		DEFAULT_MAX_TIMEOUT_S,
+		DEFAULT_PERIOD_MS * NSEC_PER_MSEC,
+		DEFAULT_MIN_PERIOD_MS * NSEC_PER_MSEC,
+		DEFAULT_PRIORITY,
+		false,
+	};
+	std::vector < struct source_state >state;
+	gid_t gid = (gid_t) - 1;
+	int lock_fd;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "r:o:t:T:i:m:p:w:ng:b:dh")) != -1) {
+		switch (opt) {
+		case 'r':
+		case 'o':
+			if (!add_source(state, optarg, 'r' == opt)) {
+				fprintf(stderr, "invalid source '%s'\n",
+					optarg);
+				return -1;
+			}
+			break;
+		case 't':
+			cfg.timeout_s = atoi(optarg);
+			break;
+		case 'T':
+			cfg.max_timeout_s = atoi(optarg);
+			break;
+		case 'i':
+			cfg.max_period_ns = strtoull(optarg, NULL, 0)
+			    * NSEC_PER_MSEC;
+			break;
+		case 'm':
+			cfg.min_period_ns = strtoull(optarg, NULL, 0)
+			    * NSEC_PER_MSEC;
+			break;
+		case 'p':
+			cfg.priority = atoi(optarg);
+			break;
+		case 'w':
+			cfg.device = optarg;
+			break;
+		case 'n':
+			cfg.nowayout = true;
+			break;
+		case 'g':
+			if (!lookup_group(optarg, &gid)) {
+				fprintf(stderr, "unknown group '%s'\n", optarg);
+				return -1;
+			}
+			break;
+		case 'b':
+			{
+				volatile uint64_t *const beats =
+				    bbapi_watchdog_attach(optarg);
+				if (!beats) {
+					fprintf(stderr, "unknown source '%s'\n",
+						optarg);
+					return -1;
+				}
+				bbapi_watchdog_beat(beats);
+				return 0;
+			}
+		case 'd':
+			return dump();
+		default:
+			usage(argv[0]);
+			return -1;
+		}
+	}
+
+	if (optind != argc || cfg.timeout_s <= 0
+	    || cfg.max_timeout_s < cfg.timeout_s || !cfg.min_period_ns
+	    || cfg.min_period_ns > cfg.max_period_ns) {
+		usage(argv[0]);
+		return -1;
+	}
+
+	struct bbapi_watchdog_shm *const shm = (struct bbapi_watchdog_shm *)
+	    create_file(BBAPI_WATCHDOG_SHM, sizeof(*shm), 0644, (gid_t) - 1,
+			&lock_fd);
+	if (!shm) {
+		if (EBUSY == errno) {
+			fprintf(stderr, "bbapi_watchdogd is already running\n");
+		} else {
+			perror(BBAPI_WATCHDOG_SHM);
+		}
+		return -1;
+	}
+	struct bbapi_watchdog_beats *const counters =
+	    (struct bbapi_watchdog_beats *)create_file(BBAPI_WATCHDOG_BEATS,
+						       sizeof(*counters),
+						       0660, gid, NULL);
+	if (!counters) {
+		perror(BBAPI_WATCHDOG_BEATS);
+		unlink(BBAPI_WATCHDOG_SHM);
+		return -1;
+	}
+	shm->num_sources = state.size();
+	publish_sources(shm, state);
+	shm->pid = getpid();
+	shm->version = BBAPI_WATCHDOG_VERSION;
+	__atomic_store_n(&shm->magic, BBAPI_WATCHDOG_MAGIC, __ATOMIC_RELEASE);
+
+	signal(SIGINT, on_signal);
+	signal(SIGTERM, on_signal);
+
+	if (mlockall(MCL_CURRENT | MCL_FUTURE)) {
+		perror("mlockall");
+	}
+
+	struct sched_param param;
+	param.sched_priority = cfg.priority;
+	if (sched_setscheduler(0, SCHED_FIFO, &param)) {
+		perror("SCHED_FIFO");
+	}
+
+	const int fd = open(cfg.device, O_WRONLY | O_CLOEXEC);
+	if (-1 == fd) {
+		perror(cfg.device);
+		unlink(BBAPI_WATCHDOG_BEATS);
+		unlink(BBAPI_WATCHDOG_SHM);
+		return -1;
+	}
+
+	int timeout = cfg.timeout_s;
+	if (ioctl(fd, WDIOC_SETTIMEOUT, &timeout)) {
+		perror("WDIOC_SETTIMEOUT");
+	}
+
+	struct bbapi_watchdog_stats stats;
+	memset(&stats, 0, sizeof(stats));
+	stats.timeout_s = timeout;
+	stats.latency_min_ns = UINT64_MAX;
+
+	uint64_t now = bbapi_clock_ns();
+	uint64_t last_adjust_ns = now;
+	uint64_t period = adapt(&cfg, fd, &stats, &last_adjust_ns, now);
+	uint64_t next = now;
+	bool skipping = false;
+	for (size_t i = 0; i < state.size(); ++i) {
+		state[i].last_change_ns = now;
+	}
+
+	printf("pinging %s every %llu ms, timeout %u s, %u sources\n",
+	       cfg.device, (unsigned long long)period / NSEC_PER_MSEC,
+	       stats.timeout_s, shm->num_sources);
+	fflush(stdout);
+
+	while (!g_stop) {
+		struct timespec ts;
+
+		next += period;
+		ts.tv_sec = next / NSEC_PER_SEC;
+		ts.tv_nsec = next % NSEC_PER_SEC;
+		if (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL)) {
+			continue;
+		}
+
+		now = bbapi_clock_ns();
+		const bool healthy = check_sources(counters, state, now);
+		if (healthy) {
+			if (ioctl(fd, WDIOC_KEEPALIVE, 0)) {
+				perror("WDIOC_KEEPALIVE");
+			}
+			const uint64_t latency = bbapi_clock_ns() - next;
+			const uint64_t decayed = stats.latency_recent_ns
+			    - (stats.latency_recent_ns >> DECAY_SHIFT);
+			stats.latency_recent_ns = std::max(latency, decayed);
+			stats.latency_min_ns =
+			    std::min(stats.latency_min_ns, latency);
+			stats.latency_max_ns =
+			    std::max(stats.latency_max_ns, latency);
+			stats.latency_sum_ns += latency;
+			++stats.pings;
+		} else {
+			if (!skipping) {
+				printf("required source unhealthy, "
+				       "watchdog fires in %u s\n",
+				       stats.timeout_s);
+				fflush(stdout);
+			}
+			++stats.skipped;
+		}
+		skipping = !healthy;
+
+		period = adapt(&cfg, fd, &stats, &last_adjust_ns, now);
+		stats.period_us = period / 1000;
+
+		stats_write_begin(shm);
+		stats.seq = shm->stats.seq;
+		shm->stats = stats;
+		publish_sources(shm, state);
+		stats_write_end(shm);
+	}
+
+	if (!cfg.nowayout && 1 != write(fd, "V", 1)) {
+		perror("magic close");
+	}
+	close(fd);
+	unlink(BBAPI_WATCHDOG_BEATS);
+	unlink(BBAPI_WATCHDOG_SHM);
+	close(lock_fd);
+	return 0;
+}
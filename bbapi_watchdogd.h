@@ -0,0 +1,180 @@
+// SPDX-License-Identifier: MIT
+/**
+    Shared memory layout of bbapi_watchdogd and the heartbeat client API
+
+    A supervised process attaches to the slot reserved for its name and
+    increments the counter, no system call is involved:
+
+      volatile uint64_t *beat = bbapi_watchdog_attach("plc");
+      for (;;) {
+              do_work();
+              bbapi_watchdog_beat(beat);
+      }
+
+    The daemon publishes its configuration and state in BBAPI_WATCHDOG_SHM,
+    which only the daemon can write. The heartbeat counters are the only
+    thing clients can write, they live in BBAPI_WATCHDOG_BEATS, which is
+    writable by the group given to bbapi_watchdogd with -g.
+
+    Copyright (C) 2026 Beckhoff Automation GmbH & Co. KG
+*/
+
+#ifndef _BBAPI_WATCHDOGD_H_
+#define _BBAPI_WATCHDOGD_H_
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+
+#define BBAPI_WATCHDOG_SHM "/dev/shm/bbapi_watchdogd"
+#define BBAPI_WATCHDOG_BEATS "/dev/shm/bbapi_watchdogd.beats"
+#define BBAPI_WATCHDOG_MAGIC 0x67646477	/* "wddg" */
+#define BBAPI_WATCHDOG_VERSION 2
+#define BBAPI_WATCHDOG_MAX_SOURCES 32
+#define BBAPI_WATCHDOG_MAX_NAME 32
+
+/**
+ * struct bbapi_watchdog_source - one supervised process
+ * @beats: value of the heartbeat counter at the last check
+ * @name: identifier used by the client to attach
+ * @timeout_ms: the source is unhealthy without heartbeat for this long
+ * @required: the watchdog is only pinged while the source is healthy
+ * @healthy: state of the last check
+ * @age_ms: time since the last heartbeat at the last check
+ * @misses: number of transitions from healthy to unhealthy
+ */
+struct bbapi_watchdog_source {
+	uint64_t beats;
+	char name[BBAPI_WATCHDOG_MAX_NAME];
+	uint32_t timeout_ms;
+	uint32_t required;
+	uint32_t healthy;
+	uint32_t age_ms;
+	uint64_t misses;
+};
+
+/**
+ * struct bbapi_watchdog_stats - timing of the watchdog pings
+ * @seq: sequence counter, odd while the daemon updates the statistics
+ * @timeout_s: current watchdog timeout
+ * @period_us: current ping period
+ * @pings: number of pings
+ * @skipped: number of periods without ping, because a source was unhealthy
+ * @adjustments: number of timeout changes
+ * @latency_min_ns: fastest ping (wakeup delay + WDIOC_KEEPALIVE)
+ * @latency_max_ns: slowest ping
+ * @latency_sum_ns: sum of all ping latencies, for the mean
+ * @latency_recent_ns: decaying maximum used to adapt timeout and period
+ */
+struct bbapi_watchdog_stats {
+	uint32_t seq;
+	uint32_t timeout_s;
+	uint32_t period_us;
+	uint32_t reserved;
+	uint64_t pings;
+	uint64_t skipped;
+	uint64_t adjustments;
+	uint64_t latency_min_ns;
+	uint64_t latency_max_ns;
+	uint64_t latency_sum_ns;
+	uint64_t latency_recent_ns;
+};
+
+struct bbapi_watchdog_shm {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t num_sources;
+	int32_t pid;
+	struct bbapi_watchdog_stats stats;
+	struct bbapi_watchdog_source sources[BBAPI_WATCHDOG_MAX_SOURCES];
+};
+
+/**
+ * struct bbapi_watchdog_beats - the heartbeat counters, written by clients
+ * @beats: counter of sources[i], incremented by the client
+ */
+struct bbapi_watchdog_beats {
+	uint64_t beats[BBAPI_WATCHDOG_MAX_SOURCES];
+};
+
+/**
+ * bbapi_watchdog_map() - map the state of a running bbapi_watchdogd
+ *
+ * Return: read-only mapping or NULL if the daemon is not running
+ */
+static inline const struct bbapi_watchdog_shm *bbapi_watchdog_map(void)
+{
+	const int fd = open(BBAPI_WATCHDOG_SHM, O_RDONLY | O_CLOEXEC);
+	void *shm;
+
+	if (-1 == fd) {
+		return NULL;
+	}
+	shm = mmap(NULL, sizeof(struct bbapi_watchdog_shm), PROT_READ,
+		   MAP_SHARED, fd, 0);
+	close(fd);
+	if (MAP_FAILED == shm) {
+		return NULL;
+	}
+	if (BBAPI_WATCHDOG_MAGIC !=
+	    ((const struct bbapi_watchdog_shm *)shm)->magic
+	    || BBAPI_WATCHDOG_VERSION !=
+	    ((const struct bbapi_watchdog_shm *)shm)->version) {
+		munmap(shm, sizeof(struct bbapi_watchdog_shm));
+		return NULL;
+	}
+	return (const struct bbapi_watchdog_shm *)shm;
+}
+
+/**
+ * bbapi_watchdog_attach() - lookup the heartbeat counter of a source
+ * @name: source name as configured for bbapi_watchdogd
+ *
+ * The caller has to be member of the group given to bbapi_watchdogd -g.
+ *
+ * Return: pointer to the counter or NULL if @name is not configured
+ */
+static inline volatile uint64_t *bbapi_watchdog_attach(const char *name)
+{
+	const struct bbapi_watchdog_shm *const shm = bbapi_watchdog_map();
+	uint32_t index = BBAPI_WATCHDOG_MAX_SOURCES;
+	void *beats;
+
+	if (!shm) {
+		return NULL;
+	}
+	for (uint32_t i = 0; i < shm->num_sources
+	     && i < BBAPI_WATCHDOG_MAX_SOURCES; ++i) {
+		if (!strncmp(name, shm->sources[i].name,
+			     BBAPI_WATCHDOG_MAX_NAME)) {
+			index = i;
+			break;
+		}
+	}
+	munmap((void *)shm, sizeof(*shm));
+	if (BBAPI_WATCHDOG_MAX_SOURCES == index) {
+		return NULL;
+	}
+
+	const int fd = open(BBAPI_WATCHDOG_BEATS, O_RDWR | O_CLOEXEC);
+	if (-1 == fd) {
+		return NULL;
+	}
+	beats = mmap(NULL, sizeof(struct bbapi_watchdog_beats),
+		     PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (MAP_FAILED == beats) {
+		return NULL;
+	}
+	return &((struct bbapi_watchdog_beats *)beats)->beats[index];
+}
+
+static inline void bbapi_watchdog_beat(volatile uint64_t * beats)
+{
+	__atomic_fetch_add(beats, 1, __ATOMIC_RELEASE);
+}
+
+#endif /* #ifndef _BBAPI_WATCHDOGD_H_ */
@@ -0,0 +1,467 @@
+// SPDX-License-Identifier: MIT
+/**
+    Command line access to all readable BBAPI values
+
+    usage: bbapictl [-b <device>] [-f json|csv] dump [<group>...]
+           bbapictl [-b <device>] [-r <Hz>] watch [<group>...]
+
+    dump reads all values of the selected groups (default: all) in one
+    pass per group through a single open file descriptor and prints them
+    decoded as JSON or CSV. Values the platform doesn't support are left
+    out. The SYSTEM group enumerates all sensors.
+
+    watch refreshes a terminal view of the selected groups with <Hz> and
+    shows the BIOS calls per second and the share of time spent in the
+    BIOS caused by the view itself. Identification strings are only read
+    once, the numbers are read on each refresh.
+
+    Groups: general, pwrctrl, sups, cxpwrsupp, cxups, system
+
+    Copyright (C) 2026 Beckhoff Automation GmbH & Co. KG
+*/
+
+#include "bbapi_client.h"
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#define DEFAULT_RATE 1
+
+static const struct {
+	const char *name;
+	uint32_t group;
+} GROUPS[] = {
+	{"general", BIOSIGRP_GENERAL},
+	{"pwrctrl", BIOSIGRP_PWRCTRL},
+	{"sups", BIOSIGRP_SUPS},
+	{"cxpwrsupp", BIOSIGRP_CXPWRSUPP},
+	{"cxups", BIOSIGRP_CXUPS},
+	{"system", BIOSIGRP_SYSTEM},
+};
+
+#define NUM_GROUPS (sizeof(GROUPS) / sizeof(GROUPS[0]))
+
+enum text_type {
+	TEXT_STRING,
+	TEXT_VERSION,
+	TEXT_REVISION,
+};
+
+/* identification values, decoded to strings */
+static const struct {
+	const char *name;
+	uint32_t group;
+	uint32_t offset;
+	uint32_t size;
+	enum text_type type;
+} TEXTS[] = {
+	{"GENERAL_VERSION", BIOSIGRP_GENERAL, BIOSIOFFS_GENERAL_VERSION,
+	 sizeof(BADEVICE_VERSION), TEXT_VERSION},
+	{"GENERAL_GETBOARDNAME", BIOSIGRP_GENERAL,
+	 BIOSIOFFS_GENERAL_GETBOARDNAME, BAGEN_MAX_MAINBOARD_TYPE, TEXT_STRING},
+	{"PWRCTRL_BOOTLDR_REV", BIOSIGRP_PWRCTRL, BIOSIOFFS_PWRCTRL_BOOTLDR_REV,
+	 3, TEXT_REVISION},
+	{"PWRCTRL_FIRMWARE_REV", BIOSIGRP_PWRCTRL,
+	 BIOSIOFFS_PWRCTRL_FIRMWARE_REV, 3, TEXT_REVISION},
+	{"PWRCTRL_SERIAL_NUMBER", BIOSIGRP_PWRCTRL,
+	 BIOSIOFFS_PWRCTRL_SERIAL_NUMBER, PWRCTRL_MAX_SERIAL_NUMBER,
+	 TEXT_STRING},
+};
+
+/**
+ * struct record - one decoded value
+ * @group: index into GROUPS
+ * @name: value name, as used by bbapi_recorder
+ * @unit: unit of @value
+ * @value: decoded number, valid if @text is empty
+ * @text: decoded identification string
+ * @sensor: complete sensor information for the SYSTEM group
+ */
+struct record {
+	size_t group;
+	std::string name;
+	const char *unit;
+	int64_t value;
+	std::string text;
+	SENSORINFO sensor;
+};
+
+/**
+ * struct reader - /dev/bbapi with accounting of all BIOS calls
+ */
+struct reader {
+	int fd;
+	uint64_t calls;
+	uint64_t busy_ns;
+
+	bool read(uint32_t group, uint32_t offset, void *out, uint32_t size) {
+		const uint64_t start = bbapi_clock_ns();
+		const int result = bbapi_ioctl_read(fd, group, offset, out, size);
+		busy_ns += bbapi_clock_ns() - start;
+		++calls;
+		return !result;
+	}
+};
+
+static volatile sig_atomic_t g_stop;
+
+static void on_signal(int sig)
+{
+	g_stop = 1;
+}
+
+static void read_texts(struct reader *r, size_t group,
+		       std::vector < struct record >&records)
+{
+	for (size_t i = 0; i < sizeof(TEXTS) / sizeof(TEXTS[0]); ++i) {
+		uint8_t raw[64] = { 0 };
+		char text[64];
+
+		if (GROUPS[group].group != TEXTS[i].group
+		    || !r->read(TEXTS[i].group, TEXTS[i].offset, raw,
+				TEXTS[i].size)) {
+			continue;
+		}
+
+		switch (TEXTS[i].type) {
+		case TEXT_STRING:
+			snprintf(text, sizeof(text), "%.*s", TEXTS[i].size,
+				 (const char *)raw);
+			break;
+		case TEXT_VERSION:
+			{
+				const BADEVICE_VERSION *const v =
+				    (const BADEVICE_VERSION *)raw;
+				snprintf(text, sizeof(text), "%u.%u.%u",
+					 v->version, v->revision, v->build);
+				break;
+			}
+		case TEXT_REVISION:
+			snprintf(text, sizeof(text), "%u.%u-%u", raw[0], raw[1],
+				 raw[2]);
+			break;
+		}
+
+		struct record rec;
+		rec.group = group;
+		rec.name = TEXTS[i].name;
+		rec.unit = "";
+		rec.value = 0;
+		rec.text = text;
+		records.push_back(rec);
+	}
+}
+
+static void read_sensors(struct reader *r, size_t group,
+			 std::vector < struct record >&records)
+{
+	uint32_t num_sensors;
+
+	if (!r->read(BIOSIGRP_SYSTEM, BIOSIOFFS_SYSTEM_COUNT_SENSORS,
+		     &num_sensors, sizeof(num_sensors))) {
+		return;
+	}
+
+	for (uint32_t i = BIOSIOFFS_SYSTEM_SENSOR_MIN; i <= num_sensors; ++i) {
+		struct record rec;
+		if (!r->read(BIOSIGRP_SYSTEM, i, &rec.sensor,
+			     sizeof(rec.sensor))
+		    || INFOVALUE_STATUS_UNUSED == rec.sensor.readVal.status) {
+			continue;
+		}
+		rec.group = group;
+		rec.name = BBAPI_SENSOR_PREFIX + std::to_string(i);
+		rec.unit = "";
+		rec.value = rec.sensor.readVal.value;
+		records.push_back(rec);
+	}
+}
+
+/**
+ * read_group() - read all values of one group in a single pass
+ * @with_texts: false to skip the identification strings
+ */
+static void read_group(struct reader *r, size_t group, bool with_texts,
+		       std::vector < struct record >&records)
+{
+	if (BIOSIGRP_SYSTEM == GROUPS[group].group) {
+		read_sensors(r, group, records);
+		return;
+	}
+
+	if (with_texts) {
+		read_texts(r, group, records);
+	}
+
+	for (size_t i = 0; i < BBAPI_NUM_VALUES; ++i) {
+		const struct bbapi_value *const v = &BBAPI_VALUES[i];
+		uint8_t raw[8];
+
+		if (GROUPS[group].group != v->group
+		    || !r->read(v->group, v->offset, raw, v->size)) {
+			continue;
+		}
+
+		struct record rec;
+		rec.group = group;
+		rec.name = v->name;
+		rec.unit = v->unit;
+		rec.value = bbapi_decode_value(v, raw);
+		records.push_back(rec);
+	}
+}
+
+static void print_json_string(const char *s)
+{
+	putchar('"');
+	for (; *s; ++s) {
+		if ('"' == *s || '\\' == *s) {
+			printf("\\%c", *s);
+		} else if ((unsigned char)*s < 0x20) {
+			printf("\\u%04x", *s);
+		} else {
+			putchar(*s);
+		}
+	}
+	putchar('"');
+}
+
+static void print_json(const char *device, const struct reader *r,
+		       const std::vector < struct record >&records)
+{
+	size_t group = NUM_GROUPS;
+
+	printf("{\n  \"device\": ");
+	print_json_string(device);
+	printf(",\n  \"time\": %.3f,\n  \"calls\": %llu,\n"
+	       "  \"duration_us\": %llu,\n  \"groups\": {",
+	       bbapi_clock_ns(CLOCK_REALTIME) / 1e9,
+	       (unsigned long long)r->calls,
+	       (unsigned long long)r->busy_ns / 1000);
+
+	for (size_t i = 0; i < records.size(); ++i) {
+		const struct record &rec = records[i];
+		if (group != rec.group) {
+			printf("%s\n    \"%s\": {", NUM_GROUPS == group ? ""
+			       : "\n    },", GROUPS[rec.group].name);
+			group = rec.group;
+		} else {
+			printf(",");
+		}
+
+		printf("\n      ");
+		print_json_string(rec.name.c_str());
+		printf(": ");
+		if (!rec.text.empty()) {
+			print_json_string(rec.text.c_str());
+		} else if (BIOSIGRP_SYSTEM == GROUPS[rec.group].group) {
+			const SENSORINFO &s = rec.sensor;
+			char desc[sizeof(s.desc) + 1] = { 0 };
+			memcpy(desc, s.desc, sizeof(s.desc));
+			printf("{\"value\": %d, \"status\": %u, \"min\": %d, "
+			       "\"max\": %d, \"nominal\": %d, \"type\": ",
+			       s.readVal.value, s.readVal.status,
+			       s.minVal.value, s.maxVal.value, s.nomVal.value);
+			print_json_string(s.eType <= PROBE_MAX ?
+					  PROBECAPS[s.eType].name : "");
+			printf(", \"location\": ");
+			print_json_string(s.eLocation <= LOCATION_MAX ?
+					  LOCATIONCAPS[s.eLocation].name : "");
+			printf(", \"desc\": ");
+			print_json_string(desc);
+			printf("}");
+		} else if (*rec.unit) {
+			printf("{\"value\": %lld, \"unit\": \"%s\"}",
+			       (long long)rec.value, rec.unit);
+		} else {
+			printf("%lld", (long long)rec.value);
+		}
+	}
+	printf("%s\n  }\n}\n", NUM_GROUPS == group ? "" : "\n    }");
+}
+
+/* RFC 4180: quote the field and double embedded quotes */
+static void print_csv_string(const char *s)
+{
+	putchar('"');
+	for (; *s; ++s) {
+		if ('"' == *s) {
+			putchar('"');
+		}
+		putchar(*s);
+	}
+	putchar('"');
+}
+
+static void print_csv(const std::vector < struct record >&records)
+{
+	printf("group,name,value,unit\n");
+	for (size_t i = 0; i < records.size(); ++i) {
+		const struct record &rec = records[i];
+		printf("%s,%s,", GROUPS[rec.group].name, rec.name.c_str());
+		if (rec.text.empty()) {
+			printf("%lld", (long long)rec.value);
+		} else {
+			print_csv_string(rec.text.c_str());
+		}
+		printf(",%s\n", rec.unit);
+	}
+}
+
+static int watch(struct reader *r, const std::vector < size_t >&groups,
+		 double rate)
+{
+	std::vector < struct record >texts;
+	const uint64_t period = 1000000000ULL / rate;
+	struct timespec next;
+
+	for (size_t i = 0; i < groups.size(); ++i) {
+		read_texts(r, groups[i], texts);
+	}
+
+	signal(SIGINT, on_signal);
+	signal(SIGTERM, on_signal);
+	clock_gettime(CLOCK_MONOTONIC, &next);
+
+	/* hide the cursor while the view is active */
+	printf("\033[?25l");
+	while (!g_stop) {
+		std::vector < struct record >records;
+		const uint64_t calls = r->calls;
+		const uint64_t busy = r->busy_ns;
+		const uint64_t start = bbapi_clock_ns();
+
+		for (size_t i = 0; i < groups.size(); ++i) {
+			read_group(r, groups[i], false, records);
+		}
+
+		printf("\033[H\033[J");
+		for (size_t i = 0; i < texts.size(); ++i) {
+			printf("%-32s %s\n", texts[i].name.c_str(),
+			       texts[i].text.c_str());
+		}
+		for (size_t i = 0; i < records.size(); ++i) {
+			const struct record &rec = records[i];
+			if (BIOSIGRP_SYSTEM == GROUPS[rec.group].group) {
+				char desc[sizeof(rec.sensor.desc) + 1] = { 0 };
+				memcpy(desc, rec.sensor.desc, sizeof(desc) - 1);
+				printf("%-32s %10lld %s\n", rec.name.c_str(),
+				       (long long)rec.value, desc);
+			} else {
+				printf("%-32s %10lld %s\n", rec.name.c_str(),
+				       (long long)rec.value, rec.unit);
+			}
+		}
+
+		/* the view's own cost, extrapolated to one second */
+		const double per_sec = 1e9 / period;
+		printf("\n%.1f Hz, %.0f BIOS calls/s, %.3f%% time in BIOS"
+		       " (%.0f us per refresh)\n", rate,
+		       (r->calls - calls) * per_sec,
+		       100.0 * (r->busy_ns - busy) / period,
+		       (bbapi_clock_ns() - start) / 1000.0);
+		fflush(stdout);
+
+		next.tv_nsec += period % 1000000000ULL;
+		next.tv_sec += period / 1000000000ULL + next.tv_nsec / 1000000000;
+		next.tv_nsec %= 1000000000;
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+	}
+	printf("\033[?25h");
+	return 0;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+		"usage: %s [-b <device>] [-f json|csv] dump [<group>...]\n"
+		"       %s [-b <device>] [-r <Hz>] watch [<group>...]\n\n"
+		" -b  bbapi device (default: %s)\n"
+		" -f  output format of dump (default: json)\n"
+		" -r  refresh rate of watch (default: %d Hz)\n\n"
+		"groups:", name, name, BBAPI_DEVICE, DEFAULT_RATE);
+	for (size_t i = 0; i < NUM_GROUPS; ++i) {
+		fprintf(stderr, " %s", GROUPS[i].name);
+	}
+	fprintf(stderr, "\n");
+}
+
+int main(int argc, char *argv[])
+{
+	const char *device = BBAPI_DEVICE;
+	const char *format = "json";
+	double rate = DEFAULT_RATE;
+	std::vector < size_t > groups;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "b:f:r:h")) != -1) {
+		switch (opt) {
+		case 'b':
+			device = optarg;
+			break;
+		case 'f':
+			format = optarg;
+			break;
+		case 'r':
+			rate = atof(optarg);
+			break;
+		default:
+			usage(argv[0]);
+			return -1;
+		}
+	}
+
+	if (optind >= argc || rate <= 0
+	    || (strcmp(format, "json") && strcmp(format, "csv"))) {
+		usage(argv[0]);
+		return -1;
+	}
+
+	const char *const command = argv[optind++];
+	for (; optind < argc; ++optind) {
+		size_t g = 0;
+		while (g < NUM_GROUPS && strcmp(argv[optind], GROUPS[g].name)) {
+			++g;
+		}
+		if (NUM_GROUPS == g) {
+			fprintf(stderr, "unknown group '%s'\n", argv[optind]);
+			return -1;
+		}
+		groups.push_back(g);
+	}
+	if (groups.empty()) {
+		for (size_t g = 0; g < NUM_GROUPS; ++g) {
+			groups.push_back(g);
+		}
+	}
+
+	struct reader r = { open(device, O_RDWR), 0, 0 };
+	if (-1 == r.fd) {
+		perror(device);
+		return -1;
+	}
+
+	if (!strcmp(command, "watch")) {
+		return watch(&r, groups, rate);
+	}
+
+	if (strcmp(command, "dump")) {
+		usage(argv[0]);
+		return -1;
+	}
+
+	std::vector < struct record >records;
+	for (size_t i = 0; i < groups.size(); ++i) {
+		read_group(&r, groups[i], true, records);
+	}
+
+	if (!strcmp(format, "csv")) {
+		print_csv(records);
+	} else {
+		print_json(device, &r, records);
+	}
+	close(r.fd);
+	return 0;
+}
@@ -0,0 +1,375 @@
+// SPDX-License-Identifier: MIT
+/**
+    Cost model and shortest-job-first scheduling of bulk BIOS requests
+
+    The execution time of BIOS commands differs a lot. Reading a cached
+    value takes a few microseconds, while SENSORINFO or PWRCTRL commands
+    talk to I2C devices and take milliseconds. With only the FIFO like
+    bbapi_object->mutex a single slow request delays all fast ones queued
+    behind it. Requests flagged with BBAPI_MODE_BULK are therefore queued
+    here and granted shortest expected job first.
+
+    Copyright (C) 2026 Beckhoff Automation GmbH & Co. KG
+*/
+
+#include <linux/kernel.h>
+#include <linux/hrtimer.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/sched.h>
+
+#include "api.h"
+#include "bulk_sched.h"
+
+/**
+ * struct bbapi_bulk_waiter - a bulk request queued in bbapi_sched->queue
+ * @node: entry in bbapi_sched->queue
+ * @task: the waiting task, woken by bbapi_bulk_release()
+ * @granted: set before @task is woken, protected by bbapi_sched->lock
+ * @enqueued_ns: time the request was queued
+ * @cost_ns: predicted execution time of the request
+ * @predicted_ns: predicted wait at the time the request was queued
+ */
+struct bbapi_bulk_waiter {
+	struct list_head node;
+	struct task_struct *task;
+	bool granted;
+	u64 enqueued_ns;
+	u64 cost_ns;
+	u64 predicted_ns;
+};
+
+void bbapi_sched_init(struct bbapi_sched *s)
+{
+	memset(s, 0, sizeof(*s));
+	spin_lock_init(&s->lock);
+	INIT_LIST_HEAD(&s->queue);
+}
+
+static u64 ewma(u64 avg, u64 sample)
+{
+	if (!avg) {
+		return sample;
+	}
+	return avg - (avg >> BBAPI_COST_EWMA_SHIFT) +
+	    (sample >> BBAPI_COST_EWMA_SHIFT);
+}
+
+static uint32_t bbapi_cost_hash(uint32_t group, uint32_t offset)
+{
+	return ((group ^ (offset << 16)) * 0x9E3779B1u) >> (32 -
+							   BBAPI_COST_BITS);
+}
+
+/**
+ * bbapi_cost_find() - lookup a command in the cost table
+ * @insert: claim a slot if the command is not yet known
+ *
+ * Lookups probe at most BBAPI_COST_PROBES slots. If none of them is free,
+ * a new command replaces the least used one, so a burst of rarely used
+ * commands can't fill the table for good.
+ *
+ * You have to hold s->lock when calling this function!
+ *
+ * Return: slot of the command or NULL if unknown and @insert is false
+ */
+static struct bbapi_cost *bbapi_cost_find(struct bbapi_sched *s,
+					  uint32_t group, uint32_t offset,
+					  bool insert)
+{
+	const uint32_t hash = bbapi_cost_hash(group, offset);
+	struct bbapi_cost *victim = NULL;
+	size_t i;
+
+	for (i = 0; i < BBAPI_COST_PROBES; ++i) {
+		struct bbapi_cost *const c =
+		    &s->cost[(hash + i) % BBAPI_COST_SLOTS];
+
+		if (!c->calls) {
+			victim = c;
+			break;
+		}
+		if (c->group == group && c->offset == offset) {
+			return c;
+		}
+		if (!victim || c->calls < victim->calls) {
+			victim = c;
+		}
+	}
+
+	if (!insert) {
+		return NULL;
+	}
+	memset(victim, 0, sizeof(*victim));
+	victim->group = group;
+	victim->offset = offset;
+	return victim;
+}
+
+static u64 bbapi_cost_predict(struct bbapi_sched *s, uint32_t group,
+			      uint32_t offset)
+{
+	const struct bbapi_cost *const c =
+	    bbapi_cost_find(s, group, offset, false);
+
+	return c ? c->ewma_ns : s->default_ns;
+}
+
+/**
+ * bbapi_cost_update() - learn the execution time of a BIOS command
+ * @ns: measured duration of bbapi_call()
+ *
+ * Call this for successful commands only. Failed ones may have any
+ * IndexGroup/IndexOffset and return early, they would only pollute the
+ * table and the default.
+ */
+void bbapi_cost_update(struct bbapi_sched *s, uint32_t group,
+		       uint32_t offset, u64 ns)
+{
+	struct bbapi_cost *c;
+
+	spin_lock(&s->lock);
+	s->default_ns = ewma(s->default_ns, ns);
+	c = bbapi_cost_find(s, group, offset, true);
+	c->ewma_ns = ewma(c->ewma_ns, ns);
+	c->max_ns = max(c->max_ns, ns);
+	++c->calls;
+	spin_unlock(&s->lock);
+}
+
+/**
+ * bbapi_bulk_key() - scheduling priority of a waiter, lower runs first
+ *
+ * Aging: the key drops by one nanosecond per nanosecond waited. A new
+ * request has a key >= 0, so a request waiting longer than its own
+ * predicted cost is ahead of all new arrivals and can't starve.
+ */
+static s64 bbapi_bulk_key(const struct bbapi_bulk_waiter *w, u64 now)
+{
+	return (s64) w->cost_ns - (s64) (now - w->enqueued_ns);
+}
+
+/**
+ * bbapi_bulk_predict() - predict the wait of a new waiter
+ *
+ * You have to hold s->lock when calling this function!
+ *
+ * The rest of the current request plus all queued requests, which are
+ * ahead of @w right now.
+ */
+static u64 bbapi_bulk_predict(const struct bbapi_sched *s,
+			      const struct bbapi_bulk_waiter *w, u64 now)
+{
+	const struct bbapi_bulk_waiter *q;
+	const u64 elapsed = now - s->busy_since;
+	u64 wait = s->busy_cost > elapsed ? s->busy_cost - elapsed : 0;
+
+	list_for_each_entry(q, &s->queue, node) {
+		if (bbapi_bulk_key(q, now) <= bbapi_bulk_key(w, now)) {
+			wait += q->cost_ns;
+		}
+	}
+	return wait;
+}
+
+static void bbapi_bulk_account(struct bbapi_sched *s,
+			       const struct bbapi_bulk_waiter *w, u64 now)
+{
+	const u64 actual = now - w->enqueued_ns;
+
+	s->stats.predicted_ns += w->predicted_ns;
+	s->stats.actual_ns += actual;
+	s->stats.error_ns += actual > w->predicted_ns ?
+	    actual - w->predicted_ns : w->predicted_ns - actual;
+	s->stats.max_ns = max(s->stats.max_ns, actual);
+	pr_debug("%s(): bulk wait predicted: %llu ns actual: %llu ns\n",
+		 __func__, w->predicted_ns, actual);
+}
+
+/**
+ * bbapi_bulk_wait() - sleep until @w is granted, the deadline or a signal
+ * @deadline_ns: ktime_get_ns() based deadline or 0 to wait forever
+ *
+ * The deadline is a CLOCK_MONOTONIC hrtimer, a jiffies based timeout
+ * would overshoot it by up to a tick.
+ *
+ * Return: 0 if granted, -ETIME if the deadline expired, -EINTR if a
+ * signal is pending. A grant may still race with the error cases.
+ */
+static int bbapi_bulk_wait(struct bbapi_bulk_waiter *w, u64 deadline_ns)
+{
+	int result = 0;
+
+	for (;;) {
+		set_current_state(TASK_INTERRUPTIBLE);
+		if (READ_ONCE(w->granted)) {
+			break;
+		}
+		if (signal_pending(current)) {
+			result = -EINTR;
+			break;
+		}
+		if (!deadline_ns) {
+			schedule();
+			continue;
+		}
+		if (ktime_get_ns() >= deadline_ns) {
+			result = -ETIME;
+			break;
+		}
+		{
+			ktime_t expires = ns_to_ktime(deadline_ns);
+
+			schedule_hrtimeout(&expires, HRTIMER_MODE_ABS);
+		}
+	}
+	__set_current_state(TASK_RUNNING);
+	return result;
+}
+
+/**
+ * bbapi_bulk_acquire() - wait until this bulk request is scheduled
+ * @group: IndexGroup of the request, to predict its cost
+ * @offset: IndexOffset of the request, to predict its cost
+ * @nonblock: don't wait if another bulk request is in progress
+ * @deadline_ns: ktime_get_ns() based deadline or 0 to wait forever
+ *
+ * Return: 0 if the request is scheduled, call bbapi_bulk_release() when
+ * done. -EAGAIN if @nonblock and busy, -ETIME if the deadline expired,
+ * -EINTR if interrupted by a signal.
+ */
+int bbapi_bulk_acquire(struct bbapi_sched *s, uint32_t group,
+		       uint32_t offset, bool nonblock, u64 deadline_ns)
+{
+	struct bbapi_bulk_waiter w;
+	int result;
+	u64 now;
+
+	spin_lock(&s->lock);
+	now = ktime_get_ns();
+	++s->stats.requests;
+	w.cost_ns = bbapi_cost_predict(s, group, offset);
+	if (!s->busy) {
+		s->busy = true;
+		s->busy_since = now;
+		s->busy_cost = w.cost_ns;
+		spin_unlock(&s->lock);
+		return 0;
+	}
+
+	if (nonblock) {
+		spin_unlock(&s->lock);
+		return -EAGAIN;
+	}
+
+	w.task = current;
+	w.granted = false;
+	w.enqueued_ns = now;
+	w.predicted_ns = bbapi_bulk_predict(s, &w, now);
+	list_add_tail(&w.node, &s->queue);
+	++s->stats.queued;
+	spin_unlock(&s->lock);
+
+	result = bbapi_bulk_wait(&w, deadline_ns);
+
+	spin_lock(&s->lock);
+	if (!w.granted) {
+		list_del(&w.node);
+		++s->stats.aborted;
+		spin_unlock(&s->lock);
+		return result;
+	}
+	// granted, even if we raced with a signal, but not after the deadline
+	now = ktime_get_ns();
+	if (deadline_ns && now >= deadline_ns) {
+		++s->stats.aborted;
+		spin_unlock(&s->lock);
+		bbapi_bulk_release(s);
+		return -ETIME;
+	}
+	bbapi_bulk_account(s, &w, now);
+	spin_unlock(&s->lock);
+	return 0;
+}
+
+/**
+ * bbapi_bulk_release() - finish a bulk request and schedule the next one
+ */
+void bbapi_bulk_release(struct bbapi_sched *s)
+{
+	struct bbapi_bulk_waiter *w;
+	struct bbapi_bulk_waiter *next = NULL;
+	s64 next_key = 0;
+	u64 now;
+
+	spin_lock(&s->lock);
+	now = ktime_get_ns();
+	list_for_each_entry(w, &s->queue, node) {
+		const s64 key = bbapi_bulk_key(w, now);
+
+		if (!next || key < next_key) {
+			next = w;
+			next_key = key;
+		}
+	}
+
+	if (!next) {
+		s->busy = false;
+		spin_unlock(&s->lock);
+		return;
+	}
+
+	list_del(&next->node);
+	WRITE_ONCE(next->granted, true);
+	s->busy_since = now;
+	s->busy_cost = next->cost_ns;
+	// under s->lock, the waiter can't return and free @next before
+	wake_up_process(next->task);
+	spin_unlock(&s->lock);
+}
+
+static u64 avg_us(u64 sum_ns, u64 count)
+{
+	return count ? div64_u64(sum_ns, count * NSEC_PER_USEC) : 0;
+}
+
+/**
+ * bbapi_sched_show() - dump the cost model and the bulk wait statistics
+ */
+int bbapi_sched_show(struct seq_file *m, void *v)
+{
+	struct bbapi_sched *const s = m->private;
+	struct bbapi_bulk_stats stats;
+	size_t i;
+
+	spin_lock(&s->lock);
+	stats = s->stats;
+	spin_unlock(&s->lock);
+
+	seq_printf(m, "bulk requests: %llu queued: %llu aborted: %llu\n",
+		   stats.requests, stats.queued, stats.aborted);
+	seq_printf(m,
+		   "bulk wait [us] predicted: %llu actual: %llu error: %llu max: %llu\n",
+		   avg_us(stats.predicted_ns, stats.queued - stats.aborted),
+		   avg_us(stats.actual_ns, stats.queued - stats.aborted),
+		   avg_us(stats.error_ns, stats.queued - stats.aborted),
+		   avg_us(stats.max_ns, 1));
+	seq_printf(m, "\n%10s %6s %10s %10s %10s\n", "group", "offset",
+		   "calls", "ewma [us]", "max [us]");
+
+	spin_lock(&s->lock);
+	for (i = 0; i < BBAPI_COST_SLOTS; ++i) {
+		const struct bbapi_cost *const c = &s->cost[i];
+
+		if (c->calls) {
+			seq_printf(m, "0x%08x 0x%04x %10llu %10llu %10llu\n",
+				   c->group, c->offset, c->calls,
+				   avg_us(c->ewma_ns, 1), avg_us(c->max_ns,
+								 1));
+		}
+	}
+	seq_printf(m, "%10s %6s %10s %10llu\n", "default", "", "",
+		   avg_us(s->default_ns, 1));
+	spin_unlock(&s->lock);
+	return 0;
+}
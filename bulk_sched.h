@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: MIT
+/**
+    Cost model and shortest-job-first scheduling of bulk BIOS requests
+    Copyright (C) 2026 Beckhoff Automation GmbH & Co. KG
+*/
+
+#ifndef _BULK_SCHED_H_
+#define _BULK_SCHED_H_
+
+#include <linux/list.h>
+#include <linux/seq_file.h>
+#include <linux/spinlock.h>
+#include <linux/types.h>
+
+#define BBAPI_COST_BITS 8
+#define BBAPI_COST_SLOTS (1 << BBAPI_COST_BITS)
+#define BBAPI_COST_PROBES 8	// longest probe sequence, then the least used slot is replaced
+#define BBAPI_COST_EWMA_SHIFT 3	// weight of a new sample is 1/8, like TCP srtt
+
+/**
+ * struct bbapi_cost - measured execution time of one BIOS command
+ * @group: IndexGroup of the command
+ * @offset: IndexOffset of the command
+ * @calls: number of measured calls, zero for an unused slot
+ * @ewma_ns: exponentially weighted moving average of the bbapi_call() time
+ * @max_ns: slowest call
+ */
+struct bbapi_cost {
+	uint32_t group;
+	uint32_t offset;
+	u64 calls;
+	u64 ewma_ns;
+	u64 max_ns;
+};
+
+/**
+ * struct bbapi_bulk_stats - predicted and actual wait of queued bulk requests
+ * @requests: number of bulk requests
+ * @queued: number of bulk requests, which had to wait for another one
+ * @aborted: number of queued requests, which failed by deadline or signal
+ * @predicted_ns: sum of predicted waits of granted requests
+ * @actual_ns: sum of actual waits of granted requests
+ * @error_ns: sum of absolute prediction errors
+ * @max_ns: longest actual wait
+ */
+struct bbapi_bulk_stats {
+	u64 requests;
+	u64 queued;
+	u64 aborted;
+	u64 predicted_ns;
+	u64 actual_ns;
+	u64 error_ns;
+	u64 max_ns;
+};
+
+/**
+ * struct bbapi_sched - cost model and queue of bulk requests
+ * @lock: protects all members, never held during a BIOS call
+ * @cost: open addressing hash table of recently used BIOS commands
+ * @default_ns: moving average over all commands, used for unknown commands
+ * @queue: bulk requests waiting for @busy to clear
+ * @busy: a bulk request is in progress
+ * @busy_since: time the current bulk request was granted
+ * @busy_cost: predicted execution time of the current bulk request
+ * @stats: wait statistics of bulk requests
+ *
+ * Only one bulk request at a time competes with interactive and in-kernel
+ * users for bbapi_object->mutex. The others wait in @queue and are granted
+ * shortest expected job first.
+ */
+struct bbapi_sched {
+	spinlock_t lock;
+	struct bbapi_cost cost[BBAPI_COST_SLOTS];
+	u64 default_ns;
+	struct list_head queue;
+	bool busy;
+	u64 busy_since;
+	u64 busy_cost;
+	struct bbapi_bulk_stats stats;
+};
+
+extern void bbapi_sched_init(struct bbapi_sched *s);
+
+extern void bbapi_cost_update(struct bbapi_sched *s, uint32_t group,
+			      uint32_t offset, u64 ns);
+
+extern int bbapi_bulk_acquire(struct bbapi_sched *s, uint32_t group,
+			      uint32_t offset, bool nonblock, u64 deadline_ns);
+
+extern void bbapi_bulk_release(struct bbapi_sched *s);
+
+extern int bbapi_sched_show(struct seq_file *m, void *v);
+#endif /* #ifndef _BULK_SCHED_H_ */
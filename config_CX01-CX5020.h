@@ -9,11 +9,13 @@
 #define TEST_DEVICE 0x5020
 
 /** general configuration */
+#define CONFIG_GENERAL_LATENCY_BUDGET_US 500
 #define CONFIG_GENERAL_BOARDINFO {"CX553\0", 3, 0, 128}
 #define CONFIG_GENERAL_BOARDNAME "CBxx53\0\0\0\0\0\0\0\0\0"
 #define CONFIG_GENERAL_VERSION {1, 21, 1}
 
 /** PWRCTRL configuration */
+#define CONFIG_PWRCTRL_LATENCY_BUDGET_US 20000
 #define CONFIG_PWRCTRL_LAST_SHUTDOWN_ENABLED 0
 #define CONFIG_PWRCTRL_BL_REVISION {0, 14, 0}
 #define CONFIG_PWRCTRL_FW_REVISION {0, 17, 50}
@@ -24,6 +26,7 @@
 #define CONFIG_PWRCTRL_TEST_NUMBER "000000"
 
 /** S-UPS configuration */
+#define CONFIG_SUPS_LATENCY_BUDGET_US 20000
 #define CONFIG_SUPS_STATUS_OFF 0xAF
 
 /** CX Power Supply configuration */
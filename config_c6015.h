@@ -9,12 +9,14 @@
 #define TEST_DEVICE 0xC6015
 
 /** general configuration */
+#define CONFIG_GENERAL_LATENCY_BUDGET_US 500
 #define CONFIG_GENERAL_BOARDINFO {"CB3163\0", 5, 0, 118}
 #define CONFIG_GENERAL_BOARDNAME "CBxx63\0\0\0\0\0\0\0\0\0"
 #define CONFIG_GENERAL_VERSION {2, 20, 8}
 #define CONFIG_USE_GPIO_EX 1
 
 /** PWRCTRL configuration */
+#define CONFIG_PWRCTRL_LATENCY_BUDGET_US 20000
 #define CONFIG_PWRCTRL_LAST_SHUTDOWN_ENABLED 0
 #define CONFIG_PWRCTRL_BL_REVISION {1, 0, 31}
 #define CONFIG_PWRCTRL_FW_REVISION {1, 2, 0}
@@ -9,11 +9,13 @@
 #define TEST_DEVICE 0x21000004
 
 /** general configuration */
+#define CONFIG_GENERAL_LATENCY_BUDGET_US 500
 #define CONFIG_GENERAL_BOARDINFO {"CX20x0\0", 1, 1, 52}
 #define CONFIG_GENERAL_BOARDNAME "CX20x0\0\0\0\0\0\0\0\0\0"
 #define CONFIG_GENERAL_VERSION {2, 9, 1}
 
 /** PWRCTRL configuration */
+#define CONFIG_PWRCTRL_LATENCY_BUDGET_US 30000
 #define CONFIG_PWRCTRL_LAST_SHUTDOWN_ENABLED 1
 #define CONFIG_PWRCTRL_BL_REVISION {0, 14, 0}
 #define CONFIG_PWRCTRL_FW_REVISION {0, 17, 36}
@@ -27,6 +29,7 @@
 #define CONFIG_SUPS_DISABLED 1
 
 /** CX Power Supply configuration */
+#define CONFIG_CXPWRSUPP_LATENCY_BUDGET_US 30000
 #define CONFIG_CXPWRSUPP_TYPE 4
 #define CONFIG_CXPWRSUPP_SERIALNO 1467
 #define CONFIG_CXPWRSUPP_FWVERSION {5, 0}
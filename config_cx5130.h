@@ -9,12 +9,14 @@
 #define TEST_DEVICE 0x5130
 
 /** general configuration */
+#define CONFIG_GENERAL_LATENCY_BUDGET_US 500
 #define CONFIG_GENERAL_BOARDINFO {"CX51x0\0", 1, 0, 81}
 #define CONFIG_GENERAL_BOARDNAME "CBxx63\0\0\0\0\0\0\0\0\0"
 #define CONFIG_GENERAL_VERSION {2, 16, 1}
 #define CONFIG_USE_GPIO_EX 1
 
 /** PWRCTRL configuration */
+#define CONFIG_PWRCTRL_LATENCY_BUDGET_US 20000
 #define CONFIG_PWRCTRL_LAST_SHUTDOWN_ENABLED 0
 #define CONFIG_PWRCTRL_BL_REVISION {1, 0, 26}
 #define CONFIG_PWRCTRL_FW_REVISION {1, 0, 97}
@@ -25,6 +27,7 @@
 #define CONFIG_PWRCTRL_TEST_NUMBER "151020"
 
 /** S-UPS configuration */
+#define CONFIG_SUPS_LATENCY_BUDGET_US 20000
 #define CONFIG_SUPS_STATUS_OFF 0xAA
 #define CONFIG_SUPS_GPIO_PIN_EX {0, 0x4, 0x5, 0x588, 0x00400000}
 
@@ -0,0 +1,688 @@
+// SPDX-License-Identifier: MIT
+/**
+    Event driven compositor for the CX2100 text display and buttons
+
+    usage: cx2100_compositor [-r <Hz>] [-s <socket>] [-i <interface>]... [-n]
+
+    The compositor owns the display and multiplexes it between "pages".
+    Built-in pages show date, network addresses, load and memory usage.
+    Additional pages are hosted for clients connected to a local stream
+    socket: everything a client writes is interpreted like a write to
+    /dev/cx_display (see display_example.cpp) into the client's own
+    page, e.g.:
+
+      printf '\fHello\nworld' | socat - UNIX-CONNECT:/run/cx2100.sock
+
+    LEFT and RIGHT switch between the pages. UP, DOWN and ENTER are sent
+    as text lines to the client owning the visible page, which also
+    receives "SHOW" and "HIDE" when its page becomes visible or hidden.
+    The page is removed when the client disconnects.
+
+    Everything runs in a single epoll loop over the button input device,
+    the socket and two timerfds. Built-in pages are only refreshed while
+    they are visible. Lines are written to the BIOS through /dev/bbapi
+    only if their content changed and at most <Hz> times per second,
+    faster updates are coalesced.
+
+    Copyright (C) 2026 Beckhoff Automation GmbH & Co. KG
+*/
+
+#include "bbapi_client.h"
+#include <algorithm>
+#include <ctype.h>
+#include <ifaddrs.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <arpa/inet.h>
+#include <linux/input.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/un.h>
+
+#define DEFAULT_SOCKET "/run/cx2100.sock"
+#define DEFAULT_RATE 4
+#define MAX_PAGES 32
+#define NUM_ROWS ((size_t)2)
+#define NUM_COLS ((size_t)CXPWRSUPP_MAX_DISPLAY_CHARS)
+
+static const uint32_t DISPLAY_LINES[NUM_ROWS] = {
+	BIOSIOFFS_CXPWRSUPP_DISPLAYLINE1,
+	BIOSIOFFS_CXPWRSUPP_DISPLAYLINE2,
+};
+
+struct screen {
+	char cells[NUM_ROWS][CXPWRSUPP_MAX_DISPLAY_LINE];
+	bool backlight;
+
+	void clear() {
+		memset(cells, ' ', sizeof(cells));
+		for (size_t row = 0; row < NUM_ROWS; ++row) {
+			cells[row][NUM_COLS] = '\0';
+		}
+	}
+};
+
+/**
+ * struct page - content of one screen
+ * @fd: connected client socket, -1 for built-in pages
+ * @update: refreshes a built-in page, NULL for client pages
+ * @arg: argument of @update
+ * @screen: current content
+ * @row: cursor row for the display control characters
+ * @col: cursor column for the display control characters
+ */
+struct page {
+	int fd;
+	void (*update) (struct page *);
+	const char *arg;
+	struct screen screen;
+	size_t row;
+	size_t col;
+
+	page(int client, void (*fn) (struct page *) = NULL, const char *a =
+	     NULL)
+	:fd(client), update(fn), arg(a), row(0), col(0) {
+		screen.clear();
+		screen.backlight = true;
+	}
+
+	/* same semantics as display_write() of bbapi_display */
+	void write(const char *buf, size_t len) {
+		for (size_t pos = 0; pos < len; ++pos) {
+			const char next = buf[pos];
+			if (isprint((unsigned char)next) && row < NUM_ROWS) {
+				screen.cells[row][col] = next;
+				col++;
+			} else {
+				switch (next) {
+				case '\b':
+					if (col) {
+						col--;
+					} else if (row) {
+						col = NUM_COLS - 1;
+						row--;
+					}
+					break;
+				case '\t':
+					col++;
+					break;
+				case '\n':
+					col = 0;
+					row++;
+					break;
+				case '\f':
+					col = 0;
+					row = 0;
+					screen.clear();
+					break;
+				case '\r':
+					col = 0;
+					break;
+				case '\021':
+					screen.backlight = true;
+					break;
+				case '\023':
+					screen.backlight = false;
+					break;
+				default:
+					break;
+				}
+			}
+
+			if (col >= NUM_COLS) {
+				col = 0;
+				row = std::min(NUM_ROWS, row + 1);
+			}
+		}
+	}
+
+	void printf(const char *fmt, ...)
+	    __attribute__ ((format(printf, 2, 3))) {
+		char buf[2 * CXPWRSUPP_MAX_DISPLAY_LINE + 1];
+		va_list args;
+
+		va_start(args, fmt);
+		const int len = vsnprintf(buf, sizeof(buf), fmt, args);
+		va_end(args);
+		if (len > 0) {
+			write(buf, std::min((size_t)len, sizeof(buf) - 1));
+		}
+	}
+};
+
+/**
+ * struct compositor - state of the event loop
+ * @bbapi: /dev/bbapi, used to write the display lines
+ * @epoll: the one and only epoll instance
+ * @input: button event device or -1
+ * @listener: socket accepting client connections
+ * @tick: periodic 1 Hz CLOCK_REALTIME timer to refresh built-in pages
+ * @render: one-shot timer for deferred renders
+ * @signals: signalfd for SIGINT and SIGTERM
+ * @pages: all built-in and client pages
+ * @active: index of the visible page
+ * @shown: content currently on the display
+ * @shown_valid: false until @shown was written once
+ * @render_pending: @render is armed
+ * @min_interval_ns: minimum time between two renders
+ * @last_render_ns: time of the last render
+ * @line_writes: number of lines written to the BIOS
+ * @renders: number of renders
+ * @updates: number of page updates, most of them coalesced or unchanged
+ */
+struct compositor {
+	int bbapi;
+	int epoll;
+	int input;
+	int listener;
+	int tick;
+	int render;
+	int signals;
+	std::vector < struct page >pages;
+	size_t active;
+	struct screen shown;
+	bool shown_valid;
+	bool render_pending;
+	uint64_t min_interval_ns;
+	uint64_t last_render_ns;
+	uint64_t line_writes;
+	uint64_t renders;
+	uint64_t updates;
+};
+
+static void show_date(struct page *p)
+{
+	char line[2][CXPWRSUPP_MAX_DISPLAY_LINE];
+	const time_t now = time(NULL);
+	struct tm tm;
+
+	localtime_r(&now, &tm);
+	strftime(line[0], sizeof(line[0]), "%d.%m.%Y", &tm);
+	strftime(line[1], sizeof(line[1]), "%H:%M:%S", &tm);
+	p->printf("\f%s\n%s", line[0], line[1]);
+}
+
+static void show_eth(struct page *p)
+{
+	char addr[INET_ADDRSTRLEN] = "-";
+	struct ifaddrs *list;
+
+	if (!getifaddrs(&list)) {
+		for (struct ifaddrs * i = list; i; i = i->ifa_next) {
+			if (i->ifa_addr && AF_INET == i->ifa_addr->sa_family
+			    && !strcmp(p->arg, i->ifa_name)) {
+				const struct sockaddr_in *const in =
+				    (const struct sockaddr_in *)i->ifa_addr;
+				inet_ntop(AF_INET, &in->sin_addr, addr,
+					  sizeof(addr));
+				break;
+			}
+		}
+		freeifaddrs(list);
+	}
+	p->printf("\f%s:\n%s", p->arg, addr);
+}
+
+static void show_load(struct page *p)
+{
+	float load[3] = { 0 };
+	FILE *const f = fopen("/proc/loadavg", "r");
+
+	if (f) {
+		if (3 != fscanf(f, "%f %f %f", &load[0], &load[1], &load[2])) {
+			memset(load, 0, sizeof(load));
+		}
+		fclose(f);
+	}
+	p->printf("\fload:\n%.2f %.2f %.2f", load[0], load[1], load[2]);
+}
+
+static void show_mem(struct page *p)
+{
+	unsigned long total = 0;
+	unsigned long avail = 0;
+	FILE *const f = fopen("/proc/meminfo", "r");
+	char line[128];
+
+	while (f && fgets(line, sizeof(line), f)) {
+		sscanf(line, "MemTotal: %lu kB", &total);
+		sscanf(line, "MemAvailable: %lu kB", &avail);
+	}
+	if (f) {
+		fclose(f);
+	}
+	p->printf("\fmem: used  free\n%5luM %5luM", (total - avail) / 1024,
+		  avail / 1024);
+}
+
+static void arm_timer(int fd, uint64_t ns, int flags, uint64_t interval_ns)
+{
+	struct itimerspec spec;
+
+	spec.it_value.tv_sec = ns / 1000000000ULL;
+	spec.it_value.tv_nsec = ns % 1000000000ULL;
+	spec.it_interval.tv_sec = interval_ns / 1000000000ULL;
+	spec.it_interval.tv_nsec = interval_ns % 1000000000ULL;
+	timerfd_settime(fd, flags, &spec, NULL);
+}
+
+static void render_now(struct compositor *c)
+{
+	const struct screen &next = c->pages[c->active].screen;
+
+	for (size_t row = 0; row < NUM_ROWS; ++row) {
+		if (c->shown_valid
+		    && !memcmp(c->shown.cells[row], next.cells[row],
+			       sizeof(next.cells[row]))) {
+			continue;
+		}
+		if (bbapi_ioctl_write(c->bbapi, BIOSIGRP_CXPWRSUPP,
+				      DISPLAY_LINES[row], next.cells[row],
+				      sizeof(next.cells[row]))) {
+			perror("write display line");
+		}
+		++c->line_writes;
+	}
+
+	if (!c->shown_valid || c->shown.backlight != next.backlight) {
+		const uint8_t enable = next.backlight ? 0xff : 0;
+		if (bbapi_ioctl_write(c->bbapi, BIOSIGRP_CXPWRSUPP,
+				      BIOSIOFFS_CXPWRSUPP_ENABLEBACKLIGHT,
+				      &enable, sizeof(enable))) {
+			perror("write backlight");
+		}
+	}
+
+	c->shown = next;
+	c->shown_valid = true;
+	c->last_render_ns = bbapi_clock_ns();
+	++c->renders;
+}
+
+/**
+ * schedule_render() - bring the visible page onto the display
+ *
+ * Renders immediately if the last render is at least min_interval_ns ago,
+ * else the render timer is armed once for the earliest allowed time and
+ * all updates until then are coalesced into that render.
+ */
+static void schedule_render(struct compositor *c)
+{
+	++c->updates;
+	if (c->render_pending) {
+		return;
+	}
+
+	const uint64_t due = c->last_render_ns + c->min_interval_ns;
+	if (!c->shown_valid || bbapi_clock_ns() >= due) {
+		render_now(c);
+		return;
+	}
+	arm_timer(c->render, due, TFD_TIMER_ABSTIME, 0);
+	c->render_pending = true;
+}
+
+static void notify(const struct page &p, const char *event)
+{
+	if (-1 != p.fd) {
+		send(p.fd, event, strlen(event), MSG_NOSIGNAL | MSG_DONTWAIT);
+	}
+}
+
+static void switch_page(struct compositor *c, size_t next)
+{
+	if (next == c->active) {
+		return;
+	}
+	notify(c->pages[c->active], "HIDE\n");
+	c->active = next;
+	struct page &p = c->pages[next];
+	if (p.update) {
+		p.update(&p);
+	}
+	notify(p, "SHOW\n");
+	schedule_render(c);
+}
+
+static void remove_client(struct compositor *c, int fd)
+{
+	for (size_t i = 0; i < c->pages.size(); ++i) {
+		if (fd != c->pages[i].fd) {
+			continue;
+		}
+
+		const bool was_active = (i == c->active);
+		c->pages.erase(c->pages.begin() + i);
+		if (c->active > i || c->active == c->pages.size()) {
+			c->active = (c->active + c->pages.size() - 1)
+			    % c->pages.size();
+		}
+		if (was_active) {
+			struct page &p = c->pages[c->active];
+			if (p.update) {
+				p.update(&p);
+			}
+			notify(p, "SHOW\n");
+			schedule_render(c);
+		}
+		break;
+	}
+	epoll_ctl(c->epoll, EPOLL_CTL_DEL, fd, NULL);
+	close(fd);
+}
+
+static void add_fd(struct compositor *c, int fd)
+{
+	struct epoll_event ev;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.fd = fd;
+	if (epoll_ctl(c->epoll, EPOLL_CTL_ADD, fd, &ev)) {
+		perror("epoll_ctl");
+		exit(-1);
+	}
+}
+
+static void handle_accept(struct compositor *c)
+{
+	const int fd = accept4(c->listener, NULL, NULL,
+			       SOCK_NONBLOCK | SOCK_CLOEXEC);
+	if (-1 == fd) {
+		return;
+	}
+
+	if (c->pages.size() >= MAX_PAGES) {
+		close(fd);
+		return;
+	}
+	c->pages.push_back(page(fd));
+	add_fd(c, fd);
+
+	/* replace the empty placeholder page of -n */
+	const struct page &visible = c->pages[c->active];
+	if (-1 == visible.fd && !visible.update) {
+		switch_page(c, c->pages.size() - 1);
+	}
+}
+
+static void handle_client(struct compositor *c, int fd)
+{
+	char buf[256];
+	const ssize_t len = read(fd, buf, sizeof(buf));
+
+	if (len <= 0) {
+		if (0 == len || EAGAIN != errno) {
+			remove_client(c, fd);
+		}
+		return;
+	}
+
+	for (size_t i = 0; i < c->pages.size(); ++i) {
+		if (fd == c->pages[i].fd) {
+			c->pages[i].write(buf, len);
+			if (i == c->active) {
+				schedule_render(c);
+			}
+			return;
+		}
+	}
+}
+
+static void handle_key(struct compositor *c, const char *key)
+{
+	const size_t num = c->pages.size();
+
+	if (!strcmp(key, "LEFT")) {
+		switch_page(c, (c->active + num - 1) % num);
+	} else if (!strcmp(key, "RIGHT")) {
+		switch_page(c, (c->active + 1) % num);
+	} else {
+		char line[16];
+		snprintf(line, sizeof(line), "%s\n", key);
+		notify(c->pages[c->active], line);
+	}
+}
+
+static void handle_input(struct compositor *c)
+{
+	struct input_event ev[16];
+	const ssize_t len = read(c->input, ev, sizeof(ev));
+
+	if (len <= 0) {
+		if (0 == len || EAGAIN != errno) {
+			fprintf(stderr, "button device lost\n");
+			epoll_ctl(c->epoll, EPOLL_CTL_DEL, c->input, NULL);
+			close(c->input);
+			c->input = -1;
+		}
+		return;
+	}
+
+	for (size_t i = 0; i < len / sizeof(ev[0]); ++i) {
+		/* key releases and axis returning to zero are ignored */
+		if (!ev[i].value) {
+			continue;
+		}
+		if (EV_ABS == ev[i].type && ABS_X == ev[i].code) {
+			handle_key(c, ev[i].value < 0 ? "LEFT" : "RIGHT");
+		} else if (EV_ABS == ev[i].type && ABS_Y == ev[i].code) {
+			handle_key(c, ev[i].value < 0 ? "DOWN" : "UP");
+		} else if (EV_KEY == ev[i].type && BTN_0 == ev[i].code) {
+			handle_key(c, "ENTER");
+		}
+	}
+}
+
+static int open_listener(const char *path)
+{
+	struct sockaddr_un addr;
+	const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK
+			      | SOCK_CLOEXEC, 0);
+
+	if (-1 == fd || strlen(path) >= sizeof(addr.sun_path)) {
+		return -1;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+	unlink(path);
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr))
+	    || listen(fd, MAX_PAGES)) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+		"usage: %s [-r <Hz>] [-s <socket>] [-i <interface>]... [-n]\n\n"
+		" -r  maximum display refresh rate (default: %d Hz)\n"
+		" -s  path of the client socket (default: %s)\n"
+		" -i  add a built-in page for this network interface\n"
+		"     (default: eth0 and eth1)\n"
+		" -n  no built-in pages\n"
+		" -b  bbapi device (default: %s)\n"
+		" -B  button event device (default: detected by name)\n",
+		name, DEFAULT_RATE, DEFAULT_SOCKET, BBAPI_DEVICE);
+}
+
+int main(int argc, char *argv[])
+{
+	struct compositor c;
+	std::vector < const char *>interfaces;
+	const char *socket_path = DEFAULT_SOCKET;
+	const char *bbapi_path = BBAPI_DEVICE;
+	std::string button_path;
+	bool builtin = true;
+	double rate = DEFAULT_RATE;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "r:s:i:nb:B:h")) != -1) {
+		switch (opt) {
+		case 'r':
+			rate = atof(optarg);
+			break;
+		case 's':
+			socket_path = optarg;
+			break;
+		case 'i':
+			interfaces.push_back(optarg);
+			break;
+		case 'n':
+			builtin = false;
+			break;
+		case 'b':
+			bbapi_path = optarg;
+			break;
+		case 'B':
+			button_path = optarg;
+			break;
+		default:
+			usage(argv[0]);
+			return -1;
+		}
+	}
+
+	if (optind != argc || rate <= 0) {
+		usage(argv[0]);
+		return -1;
+	}
+
+	if (interfaces.empty()) {
+		interfaces.push_back("eth0");
+		interfaces.push_back("eth1");
+	}
+	if (button_path.empty()) {
+		button_path = bbapi_find_button_device();
+	}
+
+	c.bbapi = open(bbapi_path, O_RDWR | O_CLOEXEC);
+	if (-1 == c.bbapi) {
+		perror(bbapi_path);
+		return -1;
+	}
+
+	c.listener = open_listener(socket_path);
+	if (-1 == c.listener) {
+		perror(socket_path);
+		return -1;
+	}
+
+	c.input = open(button_path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+	if (-1 == c.input) {
+		fprintf(stderr, "%s: %s, buttons disabled\n",
+			button_path.c_str(), strerror(errno));
+	}
+
+	sigset_t mask;
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGINT);
+	sigaddset(&mask, SIGTERM);
+	sigprocmask(SIG_BLOCK, &mask, NULL);
+	c.signals = signalfd(-1, &mask, SFD_CLOEXEC);
+	c.tick = timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK | TFD_CLOEXEC);
+	c.render = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	c.epoll = epoll_create1(EPOLL_CLOEXEC);
+	if (-1 == c.signals || -1 == c.tick || -1 == c.render
+	    || -1 == c.epoll) {
+		perror("setup event loop");
+		return -1;
+	}
+
+	if (builtin) {
+		c.pages.push_back(page(-1, show_date));
+		for (size_t i = 0; i < interfaces.size(); ++i) {
+			c.pages.push_back(page(-1, show_eth, interfaces[i]));
+		}
+		c.pages.push_back(page(-1, show_load));
+		c.pages.push_back(page(-1, show_mem));
+	} else {
+		/* an empty page is shown while no client is connected */
+		c.pages.push_back(page(-1));
+	}
+
+	c.active = 0;
+	c.shown_valid = false;
+	c.render_pending = false;
+	c.min_interval_ns = 1000000000ULL / rate;
+	c.last_render_ns = 0;
+	c.line_writes = 0;
+	c.renders = 0;
+	c.updates = 0;
+
+	/* tick on every full second, so the clock page doesn't lag behind */
+	arm_timer(c.tick, (bbapi_clock_ns(CLOCK_REALTIME) / 1000000000ULL + 1)
+		  * 1000000000ULL, TFD_TIMER_ABSTIME, 1000000000ULL);
+
+	add_fd(&c, c.signals);
+	add_fd(&c, c.tick);
+	add_fd(&c, c.render);
+	add_fd(&c, c.listener);
+	if (-1 != c.input) {
+		add_fd(&c, c.input);
+	}
+
+	if (c.pages[0].update) {
+		c.pages[0].update(&c.pages[0]);
+	}
+	schedule_render(&c);
+
+	for (bool running = true; running;) {
+		struct epoll_event events[16];
+		const int num = epoll_wait(c.epoll, events, 16, -1);
+
+		if (-1 == num && EINTR != errno) {
+			perror("epoll_wait");
+			break;
+		}
+
+		for (int i = 0; i < num; ++i) {
+			const int fd = events[i].data.fd;
+			uint64_t expirations;
+
+			if (fd == c.signals) {
+				running = false;
+			} else if (fd == c.tick) {
+				if ((ssize_t)sizeof(expirations) !=
+				    read(fd, &expirations, sizeof(expirations))) {
+					continue;
+				}
+				struct page &p = c.pages[c.active];
+				if (p.update) {
+					p.update(&p);
+					schedule_render(&c);
+				}
+			} else if (fd == c.render) {
+				if ((ssize_t)sizeof(expirations) !=
+				    read(fd, &expirations, sizeof(expirations))) {
+					continue;
+				}
+				c.render_pending = false;
+				render_now(&c);
+			} else if (fd == c.listener) {
+				handle_accept(&c);
+			} else if (fd == c.input) {
+				handle_input(&c);
+			} else {
+				handle_client(&c, fd);
+			}
+		}
+	}
+
+	fprintf(stderr, "%llu updates, %llu renders, %llu line writes\n",
+		(unsigned long long)c.updates, (unsigned long long)c.renders,
+		(unsigned long long)c.line_writes);
+	unlink(socket_path);
+	return 0;
+}
@@ -0,0 +1,555 @@
+// SPDX-License-Identifier: MIT
+/**
+    Sensor history of the Beckhoff BIOS API
+
+    A ring buffer of periodically sampled BIOS values, to see what supply
+    voltages, currents and temperatures did in the seconds before a power
+    fail or watchdog reset. Recording stops ("freezes") automatically when:
+    - the S-UPS power fail counter changes
+    - the CX UPS switches to battery
+    - bbapi_history_freeze() is called, e.g. on watchdog pretimeout
+
+    Sampling costs a BIOS call per channel and period, so the history is
+    off by default and enabled with history_period_ms > 0.
+
+    The history is readable from <debugfs>/bbapi/history. Writing "freeze"
+    or "rearm" to that file stops or resumes recording. With history_log > 0
+    the latest samples are written to the kernel log on freeze, so they
+    survive a reset in the pstore console log, if ramoops is configured.
+
+    Copyright (C) 2026 Beckhoff Automation GmbH & Co. KG
+*/
+
+#include <linux/kernel.h>
+#include <linux/debugfs.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/moduleparam.h>
+#include <linux/mutex.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/version.h>
+#include <linux/vmalloc.h>
+#include <linux/workqueue.h>
+
+#if (LINUX_VERSION_CODE < KERNEL_VERSION(4,12,0))
+#include <asm/uaccess.h>
+#else
+#include <linux/uaccess.h>
+#endif
+
+#include "api.h"
+#include "history.h"
+#include "TcBaDevDef.h"
+
+#define BBAPI_HISTORY_MAX_CHANNELS 16
+#define BBAPI_HISTORY_MAX_DEPTH 65536
+#define BBAPI_HISTORY_INVALID S32_MIN	// value couldn't be read
+#define BBAPI_HISTORY_FROZEN 0	// bit number in bbapi_history->flags
+#define BBAPI_CXUPS_ONBATTERIES 0x02
+
+static unsigned int g_history_period_ms;
+module_param_named(history_period_ms, g_history_period_ms, uint, 0444);
+MODULE_PARM_DESC(history_period_ms,
+		 "Sampling period of the sensor history in ms, e.g. 100, default: 0 (disabled)");
+
+static unsigned int g_history_depth = 600;
+module_param_named(history_depth, g_history_depth, uint, 0444);
+MODULE_PARM_DESC(history_depth, "Number of samples in the sensor history.");
+
+static char *g_history_channels = "";
+module_param_named(history_channels, g_history_channels, charp, 0444);
+MODULE_PARM_DESC(history_channels,
+		 "Comma separated list of <group>:<offset>:<size>[s] (hex:hex:1|2|4, s for signed) or sensor<n>, default: CX2100 voltages, current, power and temperature.");
+
+static unsigned int g_history_log;
+module_param_named(history_log, g_history_log, uint, 0644);
+MODULE_PARM_DESC(history_log,
+		 "Number of latest samples written to the kernel log on freeze (for pstore console), default: 0");
+
+/**
+ * struct bbapi_history_channel - a sampled BIOS value
+ * @group: IndexGroup to read
+ * @offset: IndexOffset to read, or the sensor index for SENSORINFO
+ * @size: size of the value in bytes: 1, 2 or 4
+ * @is_signed: value is a signed integer
+ * @sensor: value is the readVal of the SENSORINFO with index @offset
+ * @name: column name in the history output
+ */
+struct bbapi_history_channel {
+	uint32_t group;
+	uint32_t offset;
+	uint32_t size;
+	bool is_signed;
+	bool sensor;
+	char name[24];
+};
+
+static const struct bbapi_history_channel DEFAULT_CHANNELS[] = {
+	{BIOSIGRP_CXPWRSUPP, BIOSIOFFS_CXPWRSUPP_GET5VOLT, 2, false, false,
+	 "5V[mV]"},
+	{BIOSIGRP_CXPWRSUPP, BIOSIOFFS_CXPWRSUPP_GET12VOLT, 2, false, false,
+	 "12V[mV]"},
+	{BIOSIGRP_CXPWRSUPP, BIOSIOFFS_CXPWRSUPP_GET24VOLT, 2, false, false,
+	 "24V[mV]"},
+	{BIOSIGRP_CXPWRSUPP, BIOSIOFFS_CXPWRSUPP_GETCURRENT, 2, false, false,
+	 "I[mA]"},
+	{BIOSIGRP_CXPWRSUPP, BIOSIOFFS_CXPWRSUPP_GETPOWER, 4, false, false,
+	 "P[mW]"},
+	{BIOSIGRP_CXPWRSUPP, BIOSIOFFS_CXPWRSUPP_GETTEMP, 1, true, false,
+	 "T[C]"},
+};
+
+/**
+ * struct bbapi_history - ring buffer of sampled BIOS values
+ * @channels: sampled values, one column per channel
+ * @num_channels: number of valid entries in @channels
+ * @times: CLOCK_REALTIME of each sample
+ * @values: g_history_depth rows of @num_channels values
+ * @head: next row to write
+ * @count: number of valid rows
+ * @lock: protects @times, @values, @head and @count
+ * @wq: workqueue of @sample_work
+ * @sample_work: periodically samples all channels and checks the triggers
+ * @log_work: reports a freeze to the kernel log, outside of atomic context
+ * @flags: BBAPI_HISTORY_FROZEN is set while recording is stopped
+ * @reason: trigger of the last freeze
+ * @frozen_ns: CLOCK_REALTIME of the last freeze
+ * @has_cxups: CXUPS power status is available
+ * @cxups_status: last CXUPS power status
+ * @has_sups: S-UPS power fail counter is available
+ * @pwrfail_count: last S-UPS power fail counter
+ * @debugfs: the "history" file
+ */
+struct bbapi_history {
+	struct bbapi_history_channel channels[BBAPI_HISTORY_MAX_CHANNELS];
+	size_t num_channels;
+	u64 *times;
+	s32 *values;
+	size_t head;
+	size_t count;
+	struct mutex lock;
+	struct workqueue_struct *wq;
+	struct delayed_work sample_work;
+	struct work_struct log_work;
+	unsigned long flags;
+	const char *reason;
+	u64 frozen_ns;
+	bool has_cxups;
+	uint8_t cxups_status;
+	bool has_sups;
+	uint16_t pwrfail_count;
+	struct dentry *debugfs;
+};
+
+static struct bbapi_history g_history;
+
+static int bbapi_history_read(const struct bbapi_history_channel *ch,
+			      s32 * value)
+{
+	uint8_t raw[4] = { 0 };
+	uint32_t v;
+
+	if (ch->sensor) {
+		SENSORINFO info;
+
+		if (bbapi_read(ch->group, ch->offset, &info, sizeof(info))
+		    || INFOVALUE_STATUS_UNUSED == info.readVal.status) {
+			return -EIO;
+		}
+		*value = info.readVal.value;
+		return 0;
+	}
+
+	if (bbapi_read(ch->group, ch->offset, raw, ch->size)) {
+		return -EIO;
+	}
+
+	v = raw[0] | raw[1] << 8 | raw[2] << 16 | (uint32_t) raw[3] << 24;
+	switch (ch->size) {
+	case 1:
+		*value = ch->is_signed ? (s8) v : (u8) v;
+		break;
+	case 2:
+		*value = ch->is_signed ? (s16) v : (u16) v;
+		break;
+	default:
+		*value = (s32) v;
+		break;
+	}
+	return 0;
+}
+
+/**
+ * bbapi_history_check() - poll the freeze triggers
+ *
+ * Only state changes trigger, a system already running on battery when the
+ * history is started doesn't freeze it right away.
+ *
+ * Return: reason for a freeze or NULL
+ */
+static const char *bbapi_history_check(struct bbapi_history *h)
+{
+	uint8_t status;
+	uint16_t count;
+
+	if (h->has_sups
+	    && !bbapi_read(BIOSIGRP_SUPS, BIOSIOFFS_SUPS_PWRFAIL_COUNTER,
+			   &count, sizeof(count))
+	    && count != h->pwrfail_count) {
+		h->pwrfail_count = count;
+		return "power fail";
+	}
+
+	if (h->has_cxups
+	    && !bbapi_read(BIOSIGRP_CXUPS, BIOSIOFFS_CXUPS_GETPOWERSTATUS,
+			   &status, sizeof(status))
+	    && status != h->cxups_status) {
+		h->cxups_status = status;
+		if (BBAPI_CXUPS_ONBATTERIES == status) {
+			return "UPS on battery";
+		}
+	}
+	return NULL;
+}
+
+static void bbapi_history_sample(struct work_struct *work)
+{
+	struct bbapi_history *const h =
+	    container_of(work, struct bbapi_history, sample_work.work);
+	const u64 now = ktime_get_real_ns();
+	s32 values[BBAPI_HISTORY_MAX_CHANNELS];
+	const char *reason;
+	size_t i;
+
+	for (i = 0; i < h->num_channels; ++i) {
+		if (bbapi_history_read(&h->channels[i], &values[i])) {
+			values[i] = BBAPI_HISTORY_INVALID;
+		}
+	}
+	reason = bbapi_history_check(h);
+
+	mutex_lock(&h->lock);
+	if (!test_bit(BBAPI_HISTORY_FROZEN, &h->flags)) {
+		h->times[h->head] = now;
+		memcpy(&h->values[h->head * h->num_channels], values,
+		       h->num_channels * sizeof(values[0]));
+		h->head = (h->head + 1) % g_history_depth;
+		h->count = min_t(size_t, h->count + 1, g_history_depth);
+	}
+	mutex_unlock(&h->lock);
+
+	// freeze after storing, to keep the sample which shows the event
+	if (reason) {
+		bbapi_history_freeze(reason);
+	}
+
+	if (!test_bit(BBAPI_HISTORY_FROZEN, &h->flags)) {
+		queue_delayed_work(h->wq, &h->sample_work,
+				   msecs_to_jiffies(g_history_period_ms));
+	}
+}
+
+/**
+ * bbapi_history_format() - format one row of the history
+ * @row: index of the row, 0 is the oldest sample
+ *
+ * You have to hold h->lock when calling this function!
+ */
+static void bbapi_history_format(const struct bbapi_history *h, size_t row,
+				 char *buf, size_t len)
+{
+	const size_t pos =
+	    (h->head + g_history_depth - h->count + row) % g_history_depth;
+	const s32 *const values = &h->values[pos * h->num_channels];
+	uint32_t ns;
+	const u64 sec = div_u64_rem(h->times[pos], NSEC_PER_SEC, &ns);
+	size_t off;
+	size_t i;
+
+	off = scnprintf(buf, len, "%llu.%03u", sec, ns / 1000000);
+	for (i = 0; i < h->num_channels; ++i) {
+		if (BBAPI_HISTORY_INVALID == values[i]) {
+			off += scnprintf(buf + off, len - off, " %10s", "-");
+		} else {
+			off += scnprintf(buf + off, len - off, " %10d",
+					 values[i]);
+		}
+	}
+}
+
+static void bbapi_history_log(struct work_struct *work)
+{
+	struct bbapi_history *const h =
+	    container_of(work, struct bbapi_history, log_work);
+	char line[32 + 11 * BBAPI_HISTORY_MAX_CHANNELS];
+	size_t first;
+	size_t i;
+
+	pr_warn("sensor history frozen: %s\n", h->reason);
+	if (!g_history_log) {
+		return;
+	}
+
+	mutex_lock(&h->lock);
+	first = h->count > g_history_log ? h->count - g_history_log : 0;
+	for (i = 0; i < h->num_channels; ++i) {
+		pr_info("history channel %zu: %s\n", i, h->channels[i].name);
+	}
+	for (i = first; i < h->count; ++i) {
+		bbapi_history_format(h, i, line, sizeof(line));
+		pr_info("history: %s\n", line);
+	}
+	mutex_unlock(&h->lock);
+}
+
+/**
+ * bbapi_history_freeze() - stop recording the sensor history
+ * @reason: static string describing the trigger
+ *
+ * Safe to call from atomic context. Only the first trigger is recorded
+ * until the history is rearmed.
+ */
+void bbapi_history_freeze(const char *reason)
+{
+	struct bbapi_history *const h = &g_history;
+
+	if (!h->wq || test_and_set_bit(BBAPI_HISTORY_FROZEN, &h->flags)) {
+		return;
+	}
+	h->reason = reason;
+	h->frozen_ns = ktime_get_real_ns();
+	schedule_work(&h->log_work);
+}
+
+EXPORT_SYMBOL(bbapi_history_freeze);
+
+static void bbapi_history_rearm(struct bbapi_history *h)
+{
+	if (test_and_clear_bit(BBAPI_HISTORY_FROZEN, &h->flags)) {
+		queue_delayed_work(h->wq, &h->sample_work, 0);
+	}
+}
+
+static int bbapi_history_show(struct seq_file *m, void *v)
+{
+	struct bbapi_history *const h = m->private;
+	char line[32 + 11 * BBAPI_HISTORY_MAX_CHANNELS];
+	size_t i;
+
+	mutex_lock(&h->lock);
+	if (test_bit(BBAPI_HISTORY_FROZEN, &h->flags)) {
+		uint32_t ns;
+		const u64 sec = div_u64_rem(h->frozen_ns, NSEC_PER_SEC, &ns);
+
+		seq_printf(m, "state: frozen at %llu.%03u by %s\n", sec,
+			   ns / 1000000, h->reason);
+	} else {
+		seq_puts(m, "state: recording\n");
+	}
+	seq_printf(m, "period: %u ms samples: %zu/%u\n\n",
+		   g_history_period_ms, h->count, g_history_depth);
+
+	seq_printf(m, "%14s", "time");
+	for (i = 0; i < h->num_channels; ++i) {
+		seq_printf(m, " %10.10s", h->channels[i].name);
+	}
+	seq_putc(m, '\n');
+
+	for (i = 0; i < h->count; ++i) {
+		bbapi_history_format(h, i, line, sizeof(line));
+		seq_printf(m, "%s\n", line);
+	}
+	mutex_unlock(&h->lock);
+	return 0;
+}
+
+static int bbapi_history_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, bbapi_history_show, inode->i_private);
+}
+
+static ssize_t bbapi_history_write(struct file *file,
+				   const char __user * buf, size_t len,
+				   loff_t * ppos)
+{
+	char cmd[16] = { 0 };
+
+	if (copy_from_user(cmd, buf, min(len, sizeof(cmd) - 1))) {
+		return -EFAULT;
+	}
+
+	if (sysfs_streq(cmd, "freeze")) {
+		bbapi_history_freeze("debugfs");
+	} else if (sysfs_streq(cmd, "rearm")) {
+		bbapi_history_rearm(&g_history);
+	} else {
+		return -EINVAL;
+	}
+	return len;
+}
+
+static const struct file_operations bbapi_history_fops = {
+	.owner = THIS_MODULE,
+	.open = bbapi_history_open,
+	.read = seq_read,
+	.write = bbapi_history_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+/**
+ * bbapi_history_parse() - parse the history_channels module parameter
+ *
+ * Return: 0 on success, -EINVAL for invalid or too many channels
+ */
+static int __init bbapi_history_parse(struct bbapi_history *h, char *list)
+{
+	char *tok;
+
+	while ((tok = strsep(&list, ","))) {
+		struct bbapi_history_channel ch = { 0 };
+		char sign = 0;
+		int n;
+
+		if (!*tok) {
+			continue;
+		}
+
+		if (h->num_channels >= BBAPI_HISTORY_MAX_CHANNELS) {
+			pr_warn("more than %d history channels\n",
+				BBAPI_HISTORY_MAX_CHANNELS);
+			return -EINVAL;
+		}
+
+		if (1 == sscanf(tok, "sensor%u", &ch.offset)) {
+			ch.group = BIOSIGRP_SYSTEM;
+			ch.sensor = true;
+			if (ch.offset < BIOSIOFFS_SYSTEM_SENSOR_MIN) {
+				pr_warn("invalid history channel: %s\n", tok);
+				return -EINVAL;
+			}
+		} else {
+			n = sscanf(tok, "%x:%x:%u%c", &ch.group, &ch.offset,
+				   &ch.size, &sign);
+			if (n < 3 || (n == 4 && 's' != sign)
+			    || (1 != ch.size && 2 != ch.size && 4 != ch.size)) {
+				pr_warn("invalid history channel: %s\n", tok);
+				return -EINVAL;
+			}
+			ch.is_signed = 4 == n;
+		}
+		snprintf(ch.name, sizeof(ch.name), "%s", tok);
+		h->channels[h->num_channels++] = ch;
+	}
+	return 0;
+}
+
+/**
+ * bbapi_history_init() - start recording the sensor history
+ * @debugfs: directory to create the "history" file in
+ *
+ * Without history_channels all default channels, which can be read on this
+ * device, are recorded. The history is optional, errors are reported but
+ * don't prevent loading the driver.
+ */
+void __init bbapi_history_init(struct dentry *debugfs)
+{
+	struct bbapi_history *const h = &g_history;
+	size_t i;
+
+	if (!g_history_period_ms || !g_history_depth) {
+		return;
+	}
+
+	if (g_history_depth > BBAPI_HISTORY_MAX_DEPTH) {
+		pr_warn("history_depth too big\n");
+		return;
+	}
+
+	mutex_init(&h->lock);
+	INIT_DELAYED_WORK(&h->sample_work, bbapi_history_sample);
+	INIT_WORK(&h->log_work, bbapi_history_log);
+
+	if (*g_history_channels) {
+		char *const list = kstrdup(g_history_channels, GFP_KERNEL);
+		const int result = list ? bbapi_history_parse(h, list) : -ENOMEM;
+
+		kfree(list);
+		if (result) {
+			h->num_channels = 0;
+			return;
+		}
+	} else if (bbapi_board_has(CXPWRSUPP, true)) {
+		for (i = 0; i < ARRAY_SIZE(DEFAULT_CHANNELS); ++i) {
+			s32 value;
+
+			if (!bbapi_history_read(&DEFAULT_CHANNELS[i], &value)) {
+				h->channels[h->num_channels++] =
+				    DEFAULT_CHANNELS[i];
+			}
+		}
+	}
+
+	if (!h->num_channels) {
+		pr_info("no sensors available for the history\n");
+		return;
+	}
+
+	h->has_sups = bbapi_board_has(SUPS, true)
+	    && !bbapi_read(BIOSIGRP_SUPS, BIOSIOFFS_SUPS_PWRFAIL_COUNTER,
+			   &h->pwrfail_count, sizeof(h->pwrfail_count));
+	h->has_cxups = bbapi_board_has(CXUPS, true)
+	    && !bbapi_read(BIOSIGRP_CXUPS, BIOSIOFFS_CXUPS_GETPOWERSTATUS,
+			   &h->cxups_status, sizeof(h->cxups_status));
+
+	h->times = vzalloc(g_history_depth * sizeof(*h->times));
+	h->values =
+	    vzalloc(g_history_depth * h->num_channels * sizeof(*h->values));
+	h->wq = create_singlethread_workqueue(KBUILD_MODNAME "_history");
+	if (!h->times || !h->values || !h->wq) {
+		pr_warn("allocating sensor history failed\n");
+		if (h->wq) {
+			destroy_workqueue(h->wq);
+			h->wq = NULL;
+		}
+		vfree(h->values);
+		vfree(h->times);
+		return;
+	}
+
+	h->debugfs =
+	    debugfs_create_file("history", 0600, debugfs, h,
+				&bbapi_history_fops);
+	queue_delayed_work(h->wq, &h->sample_work, 0);
+	pr_info("sensor history: %zu channels every %u ms, %u samples\n",
+		h->num_channels, g_history_period_ms, g_history_depth);
+}
+
+/**
+ * bbapi_history_exit() - stop the sensor history
+ *
+ * Call this first on unload, while the BIOS and the debugfs directory are
+ * still available. The "history" file is removed before the buffers are
+ * freed.
+ */
+void bbapi_history_exit(void)
+{
+	struct bbapi_history *const h = &g_history;
+	struct workqueue_struct *const wq = h->wq;
+
+	if (!wq) {
+		return;
+	}
+
+	debugfs_remove(h->debugfs);
+	h->debugfs = NULL;
+	set_bit(BBAPI_HISTORY_FROZEN, &h->flags);
+	cancel_delayed_work_sync(&h->sample_work);
+	cancel_work_sync(&h->log_work);
+	h->wq = NULL;
+	destroy_workqueue(wq);
+	vfree(h->values);
+	vfree(h->times);
+}
@@ -0,0 +1,26 @@
+// SPDX-License-Identifier: MIT
+/**
+    Sensor history of the Beckhoff BIOS API
+    Copyright (C) 2026 Beckhoff Automation GmbH & Co. KG
+*/
+
+#ifndef _HISTORY_H_
+#define _HISTORY_H_
+
+#include "api.h"
+
+struct dentry;
+
+#if BBAPI_FEATURE(HISTORY)
+extern void bbapi_history_init(struct dentry *debugfs);
+extern void bbapi_history_exit(void);
+#else
+static inline void bbapi_history_init(struct dentry *debugfs)
+{
+}
+
+static inline void bbapi_history_exit(void)
+{
+}
+#endif
+#endif /* #ifndef _HISTORY_H_ */
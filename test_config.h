@@ -7,8 +7,13 @@
 
 #pragma once
 
-/** test mode selection */
+/** test mode selection, build with -DCONFIG_INTERACTIVE=0 for regression rigs */
+#ifndef CONFIG_INTERACTIVE
 #define CONFIG_INTERACTIVE 1
+#endif
+
+/** attempts per timed read over budget, the fastest one counts */
+#define CONFIG_LATENCY_ATTEMPTS 3
 
 /** reused ranges */
 #define BOOTCOUNTER_RANGE 1, 15000
@@ -31,7 +36,27 @@
 //#include "config_cx2030_cx2100-0904.h"
 
 
+/**
+ * CONFIG_*_LATENCY_BUDGET_US: latency budgets in µs for a single BBAPI
+ * read per index group, boards override them in their config_*.h.
+ * Exceeded budgets are reported in interactive mode and fail the test in
+ * non-interactive mode.
+ */
+
+/** general configuration */
+#ifndef CONFIG_GENERAL_LATENCY_BUDGET_US
+#define CONFIG_GENERAL_LATENCY_BUDGET_US 1000
+#endif
+
+/** System configuration */
+#ifndef CONFIG_SYSTEM_LATENCY_BUDGET_US
+#define CONFIG_SYSTEM_LATENCY_BUDGET_US 5000
+#endif
+
 /** PWRCTRL configuration */
+#ifndef CONFIG_PWRCTRL_LATENCY_BUDGET_US
+#define CONFIG_PWRCTRL_LATENCY_BUDGET_US 50000
+#endif
 #define CONFIG_PWRCTRL_OPERATION_TIME_RANGE OPERATION_TIME_RANGE
 #define CONFIG_PWRCTRL_MIN_TEMP_RANGE 10, 20
 #define CONFIG_PWRCTRL_MAX_TEMP_RANGE 70, 112
@@ -42,6 +67,9 @@
 
 /** S-UPS configuration */
 #ifndef CONFIG_SUPS_DISABLED
+#ifndef CONFIG_SUPS_LATENCY_BUDGET_US
+#define CONFIG_SUPS_LATENCY_BUDGET_US 50000
+#endif
 #define CONFIG_SUPS_STATUS_ON 0xC0
 #define CONFIG_SUPS_REVISION {1, 9}
 #define CONFIG_SUPS_POWERFAILCOUNT_RANGE BOOTCOUNTER_RANGE
@@ -53,6 +81,9 @@
 #endif
 
 /** CX Power Supply configuration */
+#ifndef CONFIG_CXPWRSUPP_LATENCY_BUDGET_US
+#define CONFIG_CXPWRSUPP_LATENCY_BUDGET_US 50000
+#endif
 #define CONFIG_CXPWRSUPP_BOOTCOUNTER_RANGE BOOTCOUNTER_RANGE
 #define CONFIG_CXPWRSUPP_OPERATIONTIME_RANGE OPERATION_TIME_RANGE
 #define CONFIG_CXPWRSUPP_5VOLT_RANGE 4900, 5100
@@ -64,6 +95,9 @@
 #define CONFIG_CXPWRSUPP_BUTTON_STATE 0x00
 
 /** CX UPS configuration */
+#ifndef CONFIG_CXUPS_LATENCY_BUDGET_US
+#define CONFIG_CXUPS_LATENCY_BUDGET_US 50000
+#endif
 #define CONFIG_CXUPS_ENABLED 0
 #define CONFIG_CXUPS_FIRMWAREVER {1, 0}
 #define CONFIG_CXUPS_POWERSTATUS 1 // (BYTE) (0 := Unknown, 1 := Online, 2 := OnBatteries)
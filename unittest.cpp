@@ -20,6 +20,7 @@
 
 #include <chrono>
 #include <iostream>
+#include <limits>
 #include <thread>
 
 #include "TcBaDevDef.h"
@@ -190,7 +191,7 @@ struct TestBBAPI : fructose::test_base<TestBBAPI>
 		pr_info("\nCX power supply test case disabled\n");
 		return;
 #else
-		bbapi.setGroupOffset(BIOSIGRP_CXPWRSUPP);
+		setGroup(BIOSIGRP_CXPWRSUPP, CONFIG_CXPWRSUPP_LATENCY_BUDGET_US);
 		pr_info("\nCX power supply test results:\n=============================\n");
 		CHECK_VALUE("Type:                  %04d\n", BIOSIOFFS_CXPWRSUPP_GETTYPE, CONFIG_CXPWRSUPP_TYPE, uint32_t);
 		CHECK_VALUE("Serial:                %04d\n", BIOSIOFFS_CXPWRSUPP_GETSERIALNO, CONFIG_CXPWRSUPP_SERIALNO, uint32_t);
@@ -223,7 +224,7 @@ struct TestBBAPI : fructose::test_base<TestBBAPI>
 		static const char empty[16+1] = "                ";
 		static const char line1[16+1] = "1234567890123456";
 		static const char line2[16+1] = "6543210987654321";
-		bbapi.setGroupOffset(BIOSIGRP_CXPWRSUPP);
+		setGroup(BIOSIGRP_CXPWRSUPP, CONFIG_CXPWRSUPP_LATENCY_BUDGET_US);
 		pr_info("\nCX power supply display test:\n=============================\n");
 		uint8_t backlight = 0;
 		fructose_assert(!bbapi.ioctl_write(BIOSIOFFS_CXPWRSUPP_ENABLEBACKLIGHT, &backlight, sizeof(backlight)));
@@ -248,7 +249,7 @@ struct TestBBAPI : fructose::test_base<TestBBAPI>
 			pr_info("\nCX UPS test case disabled\n");
 			return;
 		}
-		bbapi.setGroupOffset(BIOSIGRP_CXUPS);
+		setGroup(BIOSIGRP_CXUPS, CONFIG_CXUPS_LATENCY_BUDGET_US);
 		pr_info("\nCX UPS test results:\n====================\n");
 		CHECK_VALUE("UPS enabled:           0x%02x\n", BIOSIOFFS_CXUPS_GETENABLED, CONFIG_CXUPS_ENABLED, uint8_t);
 		CHECK_CLASS("Fw ver.:                %s\n",    BIOSIOFFS_CXUPS_GETFIRMWAREVER, CONFIG_CXUPS_FIRMWAREVER, BiosPair);
@@ -292,7 +293,7 @@ struct TestBBAPI : fructose::test_base<TestBBAPI>
 
 	void test_General(const std::string& test_name)
 	{
-		bbapi.setGroupOffset(BIOSIGRP_GENERAL);
+		setGroup(BIOSIGRP_GENERAL, CONFIG_GENERAL_LATENCY_BUDGET_US);
 		pr_info("\nGeneral test results:\n=====================\n");
 		CHECK_CLASS("Mainboard: %s\n", BIOSIOFFS_GENERAL_GETBOARDINFO, CONFIG_GENERAL_BOARDINFO, BADEVICE_MBINFO);
 		CHECK_CLASS("Board: %s\n", BIOSIOFFS_GENERAL_GETBOARDNAME, CONFIG_GENERAL_BOARDNAME, BiosString<BAGEN_MAX_MAINBOARD_TYPE>);
@@ -335,7 +336,7 @@ struct TestBBAPI : fructose::test_base<TestBBAPI>
 
 	void test_PwrCtrl(const std::string& test_name)
 	{
-		bbapi.setGroupOffset(BIOSIGRP_PWRCTRL);
+		setGroup(BIOSIGRP_PWRCTRL, CONFIG_PWRCTRL_LATENCY_BUDGET_US);
 		pr_info("\nPower control test results:\n===========================\n");
 		CHECK_CLASS("Bl ver.:      %s\n", BIOSIOFFS_PWRCTRL_BOOTLDR_REV, CONFIG_PWRCTRL_BL_REVISION, BiosVersion);
 		CHECK_CLASS("Fw ver.:      %s\n", BIOSIOFFS_PWRCTRL_FIRMWARE_REV, CONFIG_PWRCTRL_FW_REVISION, BiosVersion);
@@ -360,7 +361,7 @@ struct TestBBAPI : fructose::test_base<TestBBAPI>
 		pr_info("S-UPS test case disabled\n");
 		return;
 #else
-		bbapi.setGroupOffset(BIOSIGRP_SUPS);
+		setGroup(BIOSIGRP_SUPS, CONFIG_SUPS_LATENCY_BUDGET_US);
 		pr_info("\nSUPS test results:\n==================\n");
 		uint8_t enable = 0;
 		fructose_assert(!bbapi.ioctl_write(BIOSIOFFS_SUPS_ENABLE, &enable, sizeof(enable)));
@@ -394,7 +395,7 @@ struct TestBBAPI : fructose::test_base<TestBBAPI>
 
 	void test_System(const std::string& test_name)
 	{
-		bbapi.setGroupOffset(BIOSIGRP_SYSTEM);
+		setGroup(BIOSIGRP_SYSTEM, CONFIG_SYSTEM_LATENCY_BUDGET_US);
 		uint32_t num_sensors;
 		uint32_t bytesReturned;
 		bbapi.ioctl_read(BIOSIOFFS_SYSTEM_COUNT_SENSORS, &num_sensors, sizeof(num_sensors), &bytesReturned);
@@ -409,6 +410,39 @@ struct TestBBAPI : fructose::test_base<TestBBAPI>
 
 private:
 	BiosApi bbapi;
+	long m_BudgetUs = std::numeric_limits<long>::max();
+
+	void setGroup(unsigned long group, long budget_us)
+	{
+		bbapi.setGroupOffset(group);
+		m_BudgetUs = budget_us;
+	}
+
+	/**
+	 * Read a value and check the duration of the ioctl against the latency
+	 * budget of the current group. Reads exceeding the budget are repeated
+	 * and the fastest one counts, so a single preemption doesn't fail a test.
+	 */
+	int timed_read(const std::string& nIndexOffset, uint32_t offset, void* out, unsigned long size, uint32_t *pBytesReturned)
+	{
+		long elapsed = std::numeric_limits<long>::max();
+		for (int i = 0; i < CONFIG_LATENCY_ATTEMPTS && elapsed > m_BudgetUs; ++i) {
+			const auto start = std::chrono::steady_clock::now();
+			if (-1 == bbapi.ioctl_read(offset, out, size, pBytesReturned)) {
+				return -1;
+			}
+			const auto duration = std::chrono::steady_clock::now() - start;
+			elapsed = std::min<long>(elapsed, std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+		}
+
+		if (elapsed > m_BudgetUs) {
+			pr_info("%s took %ld us, latency budget is %ld us\n", nIndexOffset.c_str(), elapsed, m_BudgetUs);
+			if (!CONFIG_INTERACTIVE) {
+				fructose_loop2_assert(nIndexOffset, m_BudgetUs, elapsed, elapsed <= m_BudgetUs);
+			}
+		}
+		return 0;
+	}
 
 	template<typename T>
 	void test_object(const std::string& nIndexOffset, const unsigned long offset, const T expectedValue, const std::string& msg, const bool doCompare = true)
@@ -416,7 +450,7 @@ private:
 		uint32_t bytesReturned;
 		char text[256];
 		T value {0};
-		fructose_loop_assert(nIndexOffset, -1 != bbapi.ioctl_read(offset, &value, sizeof(value), &bytesReturned));
+		fructose_loop_assert(nIndexOffset, -1 != timed_read(nIndexOffset, offset, &value, sizeof(value), &bytesReturned));
 		if (doCompare) {
 			fructose_loop_assert(nIndexOffset, value == expectedValue);
 		}
@@ -429,7 +463,7 @@ private:
 	{
 		uint32_t bytesReturned;
 		T value {0};
-		fructose_loop_assert(nIndexOffset, -1 != bbapi.ioctl_read(offset, &value, sizeof(value), &bytesReturned));
+		fructose_loop_assert(nIndexOffset, -1 != timed_read(nIndexOffset, offset, &value, sizeof(value), &bytesReturned));
 		fructose_loop2_assert(nIndexOffset, lower, value, lower <= value);
 		fructose_loop2_assert(nIndexOffset, upper, value, upper >= value);
 		pr_info(msg.c_str(), value);
@@ -8,12 +8,13 @@
 #include <linux/module.h>
 #include <linux/version.h>
 #include <linux/kernel.h>
+#include <linux/hrtimer.h>
 #include <linux/watchdog.h>
 
 #include "../api.h"
 #include "../TcBaDevDef.h"
 
-#define DRV_VERSION      "0.6"
+#define DRV_VERSION      "0.7"
 #define DRV_DESCRIPTION  "Beckhoff BIOS API watchdog driver"
 
 #undef pr_fmt
@@ -28,11 +29,41 @@ MODULE_PARM_DESC(nowayout,
 		 "Watchdog cannot be stopped once started (default="
 		 __MODULE_STRING(WATCHDOG_NOWAYOUT) ")");
 
+static struct watchdog_device g_wd;
+static struct hrtimer g_pretimeout;
+
 static int bbapi_wd_write(uint32_t offset, void *in, uint32_t size)
 {
 	return -bbapi_write(BIOSIGRP_WATCHDOG, offset, in, size);
 }
 
+/**
+ * The hardware has no pretimeout interrupt, so we emulate it with a timer
+ * restarted on every ping. On expiry the sensor history is frozen, before
+ * the reset overwrites what led to it.
+ */
+static enum hrtimer_restart wd_pretimeout(struct hrtimer *timer)
+{
+	bbapi_history_freeze("watchdog pretimeout");
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(4,10,0))
+	watchdog_notify_pretimeout(&g_wd);
+#endif
+	return HRTIMER_NORESTART;
+}
+
+static void wd_restart_pretimeout(struct watchdog_device *const wd)
+{
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(4,9,0))
+	if (wd->pretimeout && wd->pretimeout < wd->timeout) {
+		hrtimer_start(&g_pretimeout,
+			      ktime_set(wd->timeout - wd->pretimeout, 0),
+			      HRTIMER_MODE_REL);
+		return;
+	}
+#endif
+	hrtimer_try_to_cancel(&g_pretimeout);
+}
+
 static int wd_start(struct watchdog_device *const wd)
 {
 	static const uint32_t offset_enable =
@@ -64,8 +95,10 @@ static int wd_start(struct watchdog_device *const wd)
 	result = bbapi_wd_write(offset_timeout, &timeout, sizeof(timeout));
 	if (result) {
 		pr_warn("enable watchdog failed with: 0x%x\n", result);
+		return result;
 	}
-	return result;
+	wd_restart_pretimeout(wd);
+	return 0;
 }
 
 static int wd_ping(struct watchdog_device *wd)
@@ -79,6 +112,9 @@ static int wd_ping(struct watchdog_device *wd)
 		pr_info_once("this platform doesn't support io retrigger\n");
 		return wd_start(wd);
 	}
+	if (!result) {
+		wd_restart_pretimeout(wd);
+	}
 	return result;
 }
 
@@ -115,6 +151,7 @@ static int wd_stop(struct watchdog_device *wd)
 		pr_warn("%s(): disable watchdog failed\n", __FUNCTION__);
 		return -1;
 	}
+	hrtimer_cancel(&g_pretimeout);
 	return 0;
 }
 
@@ -128,7 +165,11 @@ static const struct watchdog_ops wd_ops = {
 };
 
 static const struct watchdog_info wd_info = {
-	.options = WDIOF_SETTIMEOUT | WDIOF_MAGICCLOSE | WDIOF_KEEPALIVEPING,
+	.options = WDIOF_SETTIMEOUT | WDIOF_MAGICCLOSE | WDIOF_KEEPALIVEPING
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(4,9,0))
+	    | WDIOF_PRETIMEOUT
+#endif
+	    ,
 	.firmware_version = 0,
 	.identity = KBUILD_MODNAME,
 };
@@ -145,12 +186,20 @@ static int __init bbapi_watchdog_init_module(void)
 	pr_info("%s, %s (nowayout=%d)\n", DRV_DESCRIPTION, DRV_VERSION,
 		nowayout);
 	watchdog_set_nowayout(&g_wd, nowayout);
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(6,13,0))
+	hrtimer_setup(&g_pretimeout, wd_pretimeout, CLOCK_MONOTONIC,
+		      HRTIMER_MODE_REL);
+#else
+	hrtimer_init(&g_pretimeout, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	g_pretimeout.function = wd_pretimeout;
+#endif
 	return watchdog_register_device(&g_wd);
 }
 
 static void __exit bbapi_watchdog_exit(void)
 {
 	watchdog_unregister_device(&g_wd);
+	hrtimer_cancel(&g_pretimeout);
 	pr_info("Watchdog unregistered\n");
 }
 